@@ -1,44 +1,59 @@
 /*
  * Actuator Tester sketch by Johan Korten
  * November 5, 2021
+ *
+ * Runs valve A, valve B, valve C and the pump in turn, 1.5 s each, with
+ * ActuatorSequencer: the steps come from a hardware timer, loop() stays
+ * free (here it reports every step). Each step switches all four outputs
+ * at once through an OutputGroup (one OUTCLR / OUTSET pair).
  */
 
+#include <ActuatorSequencer.h>
+#include <OutputGroup.h>
+
 #define pump   6
 #define valveA 5
 #define valveB 7
 #define valveC 9
 
+#define STEP_US 1500000UL
+
+// bit 0: pump, bit 1: valve A, bit 2: valve B, bit 3: valve C
+const uint8_t actuatorPins[] = { pump, valveA, valveB, valveC };
+
+const ActuatorStep testCycle[] = {
+  // delayUs  pattern  mask
+  {       0,  0b0010,  0x0F },
+  { STEP_US,  0b0100,  0x0F },
+  { STEP_US,  0b1000,  0x0F },
+  { STEP_US,  0b0001,  0x0F },
+  { STEP_US,  0b0000,  0x00 },  // keep the pump on for the last 1.5 s, then repeat
+};
+
+typedef OutputGroup<pump, valveA, valveB, valveC> Actuators;
+
+ActuatorSequencer sequencer(actuatorPins, 4);
+
+uint8_t lastStep = 0xFF;
+
 void setup() {
-  // put your setup code here, to run once:
-  pinMode(valveA, OUTPUT);
-  pinMode(valveB, OUTPUT);
-  pinMode(valveC, OUTPUT);
-  pinMode(pump, OUTPUT);    
+  Serial.begin(115200);
+
+  sequencer.begin();
+  Actuators::begin();
+  sequencer.setOutputWriter(Actuators::update);
+  sequencer.start(testCycle, sizeof(testCycle) / sizeof(testCycle[0]), true);
 }
 
 void loop() {
-  // put your main code here, to run repeatedly:
-  digitalWrite(valveA, HIGH);
-  digitalWrite(valveB, LOW);
-  digitalWrite(valveC, LOW);
-  digitalWrite(pump, LOW);
-  delay(1500);
-
-  digitalWrite(valveA, LOW);
-  digitalWrite(valveB, HIGH);
-  digitalWrite(valveC, LOW);
-  digitalWrite(pump, LOW);
-  delay(1500);
-
-  digitalWrite(valveA, LOW);
-  digitalWrite(valveB, LOW);
-  digitalWrite(valveC, HIGH);
-  digitalWrite(pump, LOW);
-  delay(1500);
-
-  digitalWrite(valveA, LOW);
-  digitalWrite(valveB, LOW);
-  digitalWrite(valveC, LOW);
-  digitalWrite(pump, HIGH);
-  delay(1500);
+  sequencer.poll(); // only needed where there is no timer
+
+  uint8_t step = sequencer.getStepIndex();
+  if (step != lastStep) {
+    lastStep = step;
+    Serial.print("cycle ");
+    Serial.print(sequencer.getCycles());
+    Serial.print(" outputs 0b");
+    Serial.println(sequencer.getPattern(), BIN);
+  }
 }
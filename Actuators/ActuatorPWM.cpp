@@ -0,0 +1,294 @@
+/*
+
+  ActuatorPWM: hardware PWM on the pump and valve pins, see ActuatorPWM.h
+
+*/
+
+#include "ActuatorPWM.h"
+
+#if defined(ARDUINO_ARCH_SAMD)
+#include "wiring_private.h" // pinPeripheral() function
+#endif
+
+#define PWM_CLOCK 48000000UL
+
+struct PwmPin {
+  uint8_t pin;
+  uint8_t tcc;
+  uint8_t channel;
+  uint8_t function;     // 'E' or 'F'
+};
+
+static const PwmPin pwmPins[] = {
+  { 5, 0, 1, 'F' },
+  { 6, 0, 2, 'F' },
+  { 7, 0, 3, 'F' },
+  { 9, 1, 1, 'E' },
+};
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+struct PwmTimer {
+  Tcc *regs;
+  IRQn_Type irq;
+  uint32_t frequency;   // 0: not set up
+  uint32_t period;      // counts per period (PER + 1)
+  uint16_t divider;     // periods per ramp tick
+  uint16_t count;
+  ActuatorPWM *channels[ACTUATOR_PWM_CHANNELS];
+};
+
+static PwmTimer timers[ACTUATOR_PWM_TCCS] = {
+  { TCC0, TCC0_IRQn, 0, 0, 1, 0, { NULL, NULL, NULL, NULL } },
+  { TCC1, TCC1_IRQn, 0, 0, 1, 0, { NULL, NULL, NULL, NULL } },
+};
+
+static void onOverflow(PwmTimer &timer) {
+  timer.regs->INTFLAG.reg = TCC_INTFLAG_OVF;
+  if (++timer.count < timer.divider) return;
+  timer.count = 0;
+
+  bool ramping = false;
+  for (uint8_t i = 0; i < ACTUATOR_PWM_CHANNELS; i++) {
+    if (timer.channels[i] != NULL) {
+      timer.channels[i]->onRampTick();
+      ramping |= timer.channels[i]->isRamping();
+    }
+  }
+  if (!ramping) timer.regs->INTENCLR.reg = TCC_INTENCLR_OVF;
+}
+
+void TCC0_Handler() {
+  onOverflow(timers[0]);
+}
+
+void TCC1_Handler() {
+  onOverflow(timers[1]);
+}
+
+// Smallest prescaler whose period fits the 24-bit counter
+static bool setupTimer(PwmTimer &timer, uint32_t frequency) {
+  static const uint16_t prescalers[] = { 1, 2, 4, 8, 16, 64, 256, 1024 };
+
+  uint8_t p = 0;
+  uint32_t period = PWM_CLOCK / frequency;
+  while ((period > 0x1000000UL) && (p < 7)) {
+    p++;
+    period = PWM_CLOCK / prescalers[p] / frequency;
+  }
+  if ((period < 2) || (period > 0x1000000UL)) return false;
+
+  Tcc *tcc = timer.regs;
+
+  if (timer.frequency == 0) {
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TCC0_TCC1;
+    while (GCLK->STATUS.bit.SYNCBUSY);
+    PM->APBCMASK.reg |= (tcc == TCC0) ? PM_APBCMASK_TCC0 : PM_APBCMASK_TCC1;
+
+    tcc->CTRLA.bit.ENABLE = 0;
+    while (tcc->SYNCBUSY.bit.ENABLE);
+    tcc->CTRLA.reg = TCC_CTRLA_SWRST;
+    while (tcc->SYNCBUSY.bit.SWRST);
+
+    tcc->CTRLA.reg = TCC_CTRLA_PRESCALER(p) | TCC_CTRLA_PRESCSYNC_PRESC;
+    tcc->WAVE.reg = TCC_WAVE_WAVEGEN_NPWM;
+    while (tcc->SYNCBUSY.bit.WAVE);
+    tcc->PER.reg = period - 1;
+    while (tcc->SYNCBUSY.bit.PER);
+
+    NVIC_SetPriority(timer.irq, 2);
+    NVIC_EnableIRQ(timer.irq);
+
+    tcc->CTRLA.bit.ENABLE = 1;
+    while (tcc->SYNCBUSY.bit.ENABLE);
+  } else if (frequency != timer.frequency) {
+    // Same prescaler only: PERB is buffered like CCB, the change lands on a period boundary
+    if (tcc->CTRLA.bit.PRESCALER != p) return false;
+    tcc->PERB.reg = period - 1;
+    while (tcc->SYNCBUSY.bit.PERB);
+  }
+
+  timer.frequency = frequency;
+  timer.period = period;
+  timer.divider = (frequency > ActuatorPWM::RAMP_TICK_HZ) ? frequency / ActuatorPWM::RAMP_TICK_HZ : 1;
+  return true;
+}
+
+#endif
+
+ActuatorPWM::ActuatorPWM(uint8_t pin) {
+  this->pin = pin;
+  tcc = -1;
+  channel = 0;
+  running = false;
+  duty = 0;
+  rampStep = 0;
+  rampTicks = 0;
+  rampTarget = 0;
+
+  for (uint8_t i = 0; i < sizeof(pwmPins) / sizeof(pwmPins[0]); i++) {
+    if (pwmPins[i].pin == pin) {
+      tcc = pwmPins[i].tcc;
+      channel = pwmPins[i].channel;
+    }
+  }
+}
+
+bool ActuatorPWM::begin(uint32_t frequency) {
+  if ((tcc < 0) || (frequency == 0) || (frequency > 1000000UL)) return false;
+
+#if defined(ARDUINO_ARCH_SAMD)
+  PwmTimer &timer = timers[tcc];
+  uint32_t previousPeriod = timer.period;
+  if (!setupTimer(timer, frequency)) return false;
+
+  // CCB of the channels already running still holds counts of the old
+  // period: rescale them, they land on the same boundary as PERB
+  if ((previousPeriod != 0) && (timer.period != previousPeriod)) {
+    for (uint8_t i = 0; i < ACTUATOR_PWM_CHANNELS; i++) {
+      ActuatorPWM *other = timer.channels[i];
+      if ((other != NULL) && (other != this)) other->write(other->getDuty());
+    }
+  }
+
+  timer.channels[channel] = this;
+  timer.regs->CC[channel].reg = 0;
+  while (timer.regs->SYNCBUSY.reg & (TCC_SYNCBUSY_CC0 << channel));
+
+  uint8_t function = 'E';
+  for (uint8_t i = 0; i < sizeof(pwmPins) / sizeof(pwmPins[0]); i++) {
+    if (pwmPins[i].pin == pin) function = pwmPins[i].function;
+  }
+  pinPeripheral(pin, (function == 'F') ? PIO_TIMER_ALT : PIO_TIMER);
+#else
+  pinMode(pin, OUTPUT);
+  lastTick = millis();
+#endif
+
+  running = true;
+  write(getDuty());
+  return true;
+}
+
+void ActuatorPWM::setDuty(uint16_t duty) {
+  noInterrupts();
+  rampTicks = 0;
+  this->duty = (uint32_t) duty << 16;
+  interrupts();
+  write(duty);
+}
+
+void ActuatorPWM::rampTo(uint16_t duty, uint32_t durationMs) {
+#if defined(ARDUINO_ARCH_SAMD)
+  uint32_t tickHz = (tcc >= 0) ? timers[tcc].frequency / timers[tcc].divider : 0;
+#else
+  uint32_t tickHz = RAMP_TICK_HZ;
+#endif
+  uint32_t ticks = (uint32_t)(((uint64_t) durationMs * tickHz) / 1000);
+  if (!running || (ticks == 0)) {
+    setDuty(duty);
+    return;
+  }
+
+  noInterrupts();
+  rampTarget = duty;
+  rampStep = (int32_t)((((int64_t) duty << 16) - (int64_t) this->duty) / (int64_t) ticks);
+  rampTicks = ticks;
+  interrupts();
+
+#if defined(ARDUINO_ARCH_SAMD)
+  PwmTimer &timer = timers[tcc];
+  timer.regs->INTFLAG.reg = TCC_INTFLAG_OVF;
+  timer.regs->INTENSET.reg = TCC_INTENSET_OVF;
+#endif
+}
+
+void ActuatorPWM::onRampTick() {
+  if (rampTicks == 0) return;
+
+  if (--rampTicks == 0) {
+    duty = (uint32_t) rampTarget << 16;
+  } else {
+    duty += rampStep;
+  }
+  write(getDuty());
+}
+
+void ActuatorPWM::stop() {
+  setDuty(0);
+  running = false;
+
+#if defined(ARDUINO_ARCH_SAMD)
+  if (tcc >= 0) timers[tcc].channels[channel] = NULL;
+#endif
+  digitalWrite(pin, LOW);
+  pinMode(pin, OUTPUT);
+}
+
+void ActuatorPWM::forceOff() {
+#if defined(ARDUINO_ARCH_SAMD)
+  uint8_t group = g_APinDescription[pin].ulPort;
+  uint32_t bit = g_APinDescription[pin].ulPin;
+
+  // low and an output first, then off the TCC: the pin never floats
+  PORT_IOBUS->Group[group].OUTCLR.reg = 1UL << bit;
+  PORT_IOBUS->Group[group].DIRSET.reg = 1UL << bit;
+  PORT_IOBUS->Group[group].PINCFG[bit].reg &= ~PORT_PINCFG_PMUXEN;
+#else
+  digitalWrite(pin, LOW);
+#endif
+
+  rampTicks = 0;
+  duty = 0;
+  running = false;
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+uint32_t ActuatorPWM::getResolution() {
+  return (tcc >= 0) ? timers[tcc].period : 0;
+}
+
+uint32_t ActuatorPWM::getFrequency() {
+  return (tcc >= 0) ? timers[tcc].frequency : 0;
+}
+
+// Into the buffer: the TCC takes it over at the end of the running period
+void ActuatorPWM::write(uint16_t duty) {
+  if (!running) return;
+
+  PwmTimer &timer = timers[tcc];
+  uint32_t cc = (duty == FULL) ? timer.period : (uint32_t)(((uint64_t) duty * timer.period) >> 16);
+
+  timer.regs->CCB[channel].reg = cc;
+  while (timer.regs->SYNCBUSY.reg & (TCC_SYNCBUSY_CCB0 << channel));
+}
+
+void ActuatorPWM::poll() {
+  // the TCC interrupt does the work
+}
+
+#else
+
+uint32_t ActuatorPWM::getResolution() {
+  return 256;
+}
+
+uint32_t ActuatorPWM::getFrequency() {
+  return 0; // analogWrite() default of the core
+}
+
+void ActuatorPWM::write(uint16_t duty) {
+  if (running) analogWrite(pin, duty >> 8);
+}
+
+void ActuatorPWM::poll() {
+  uint32_t now = millis();
+  while ((rampTicks > 0) && ((int32_t)(now - lastTick) >= 1)) {
+    lastTick++;
+    onRampTick();
+  }
+  lastTick = now;
+}
+
+#endif
@@ -0,0 +1,110 @@
+/*
+
+  ActuatorPWM: hardware PWM on the pump and valve pins, with soft-start ramps
+
+    pin 5  valve A  PA15  TCC0/WO[5]  CC1
+    pin 6  pump     PA20  TCC0/WO[6]  CC2
+    pin 7  valve B  PA21  TCC0/WO[7]  CC3
+    pin 9  valve C  PA07  TCC1/WO[1]  CC1
+
+  Counted at 48 MHz (GCLK0), so the resolution is 48 MHz / frequency:
+  2400 steps at 20 kHz, 48000 at 1 kHz. Duty is given as 0..65535
+  (65535 = always on) and scaled to the period once per update.
+
+  Duty updates go to the buffer register (CCB): the TCC copies it to CC
+  at the end of the running period, so a period is never cut short or
+  doubled, whatever the moment of the update. Ramps step the duty from
+  the TCC overflow interrupt, every frequency / 1000 periods (about
+  every millisecond, every period below 1 kHz), always on a period
+  boundary.
+
+  Pins on the same TCC share its frequency: the first begin() on a TCC
+  sets it, a later begin() with another frequency changes it for all
+  (buffered as well, their duty cycles are rescaled to the new period). analogWrite() on these pins reconfigures the TCC,
+  do not mix the two.
+
+    ActuatorPWM pumpPWM(6);
+
+    pumpPWM.begin(20000);
+    pumpPWM.rampTo(ActuatorPWM::percent(60), 2000); // soft start to 60 % in 2 s
+
+  Elsewhere the duty goes to analogWrite() (8 bit) and poll() steps the ramps.
+
+*/
+
+#ifndef ACTUATORPWM_H
+#define ACTUATORPWM_H
+
+#include <Arduino.h>
+
+#define ACTUATOR_PWM_TCCS 2
+#define ACTUATOR_PWM_CHANNELS 4 // per TCC
+
+class ActuatorPWM {
+public:
+
+  static const uint16_t FULL = 0xFFFF;
+  static const uint16_t RAMP_TICK_HZ = 1000;
+
+  static constexpr uint16_t percent(uint8_t percent) {
+    return (percent >= 100) ? FULL : (uint16_t)(((uint32_t) percent * FULL) / 100);
+  }
+
+  ActuatorPWM(uint8_t pin);
+
+  // False if the pin has no TCC output or the frequency is out of range (1 Hz .. 1 MHz)
+  bool begin(uint32_t frequency);
+
+  // Takes effect at the next period boundary, stops a running ramp
+  void setDuty(uint16_t duty);
+
+  // Linear ramp from the current duty, steps on period boundaries
+  void rampTo(uint16_t duty, uint32_t durationMs);
+
+  // Duty 0 and the pin back to a low GPIO output
+  void stop();
+
+  // Output low now, not at the period boundary: the pin is taken off the
+  // TCC with three PORT writes, no interrupts, no waiting (for interlocks).
+  // Duty 0 and stopped until the next begin()
+  void forceOff();
+
+  uint16_t getDuty() {
+    return (uint16_t)(duty >> 16);
+  }
+
+  bool isRamping() {
+    return rampTicks > 0;
+  }
+
+  // Counts per period (1 .. 2^24)
+  uint32_t getResolution();
+
+  uint32_t getFrequency();
+
+  // Steps the ramps from millis() where there is no TCC interrupt, no-op on the SAMD21
+  void poll();
+
+  // From the TCC overflow interrupt
+  void onRampTick();
+
+private:
+
+  uint8_t pin;
+  int8_t tcc;           // -1: no TCC output on this pin
+  uint8_t channel;
+  bool running;
+
+  volatile uint32_t duty;      // Q16.16
+  volatile int32_t rampStep;   // Q16.16 per tick
+  volatile uint32_t rampTicks; // ticks left
+  uint16_t rampTarget;
+
+#if !defined(ARDUINO_ARCH_SAMD)
+  uint32_t lastTick;
+#endif
+
+  void write(uint16_t duty);
+};
+
+#endif // ACTUATORPWM_H
@@ -0,0 +1,211 @@
+/*
+
+  ActuatorSequencer: timeline of actuator patterns, see ActuatorSequencer.h
+
+*/
+
+#include "ActuatorSequencer.h"
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+#define TICKS_PER_US 3         // GCLK0 48 MHz / 16
+#define MAX_CHUNK    0x8000    // ticks per compare, half the counter range
+
+static ActuatorSequencer *timerOwner = NULL;
+
+static inline void syncTC4() {
+  while (TC4->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+static inline uint16_t timerCount() {
+  return TC4->COUNT16.COUNT.reg; // continuous read request set in begin()
+}
+
+static inline void setCompare(uint16_t value) {
+  TC4->COUNT16.CC[0].reg = value;
+  syncTC4();
+}
+
+void TC4_Handler() {
+  TC4->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  if (timerOwner != NULL) timerOwner->onTimer();
+}
+
+#endif
+
+ActuatorSequencer::ActuatorSequencer(const uint8_t *pins, uint8_t count) {
+  this->pins = pins;
+  this->count = (count < ACTUATOR_MAX_OUTPUTS) ? count : ACTUATOR_MAX_OUTPUTS;
+  writer = NULL;
+  steps = NULL;
+  stepCount = 0;
+  repeat = false;
+  running = false;
+  pattern = 0;
+  stepIndex = 0;
+  cycles = 0;
+}
+
+void ActuatorSequencer::begin() {
+  for (uint8_t i = 0; i < count; i++) {
+    digitalWrite(pins[i], LOW);
+    pinMode(pins[i], OUTPUT);
+  }
+  pattern = 0;
+
+#if defined(ARDUINO_ARCH_SAMD)
+  timerOwner = this;
+
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TC4_TC5;
+  while (GCLK->STATUS.bit.SYNCBUSY);
+  PM->APBCMASK.reg |= PM_APBCMASK_TC4;
+
+  TC4->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+  while (TC4->COUNT16.CTRLA.bit.SWRST);
+
+  // Free running, the compare only raises the interrupt
+  TC4->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_NFRQ | TC_CTRLA_PRESCALER_DIV16;
+  syncTC4();
+  TC4->COUNT16.READREQ.reg = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+  syncTC4();
+
+  NVIC_SetPriority(TC4_IRQn, 1);
+  NVIC_EnableIRQ(TC4_IRQn);
+
+  TC4->COUNT16.CTRLA.bit.ENABLE = 1;
+  syncTC4();
+#endif
+}
+
+bool ActuatorSequencer::start(const ActuatorStep *steps, uint8_t count, bool repeat) {
+  if ((steps == NULL) || (count == 0)) return false;
+
+  // A repeating cycle needs MIN_DELAY_US per step on average, or the
+  // interrupt would never catch up with it
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < count; i++) total += steps[i].delayUs;
+  if (repeat && (total < (uint32_t)count * MIN_DELAY_US)) return false;
+
+  stop(pattern);
+
+  this->steps = steps;
+  this->stepCount = count;
+  this->repeat = repeat;
+  stepIndex = 0;
+  cycles = 0;
+
+#if defined(ARDUINO_ARCH_SAMD)
+  noInterrupts();
+  target = timerCount();
+  carryUs = 0;
+  running = true;
+  schedule(steps[0].delayUs);
+  TC4->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  TC4->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+  onTimer();
+  interrupts();
+#else
+  due = micros();
+  running = true;
+  schedule(steps[0].delayUs);
+#endif
+  return true;
+}
+
+void ActuatorSequencer::stop(uint8_t pattern) {
+#if defined(ARDUINO_ARCH_SAMD)
+  TC4->COUNT16.INTENCLR.reg = TC_INTENCLR_MC0;
+#endif
+  running = false;
+  apply(pattern, 0xFF);
+}
+
+void ActuatorSequencer::set(uint8_t pattern, uint8_t mask) {
+  noInterrupts();
+  apply(pattern, mask);
+  interrupts();
+}
+
+void ActuatorSequencer::apply(uint8_t pattern, uint8_t mask) {
+  if (writer != NULL) {
+    writer(pattern, mask);
+  } else {
+    uint8_t changed = (this->pattern ^ pattern) & mask;
+    for (uint8_t i = 0; i < count; i++) {
+      if (changed & (1 << i)) digitalWrite(pins[i], (pattern >> i) & 1);
+    }
+  }
+  this->pattern = (this->pattern & ~mask) | (pattern & mask);
+}
+
+bool ActuatorSequencer::nextStep() {
+  const ActuatorStep &step = steps[stepIndex];
+  apply(step.pattern, step.mask);
+
+  if (++stepIndex >= stepCount) {
+    if (!repeat) {
+      running = false;
+      return false;
+    }
+    stepIndex = 0;
+    cycles++;
+  }
+  return true;
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+// Too short for a compare of its own: applied now, waited for with the next one
+void ActuatorSequencer::schedule(uint32_t delayUs) {
+  carryUs += delayUs;
+  if (carryUs < MIN_DELAY_US) {
+    remaining = 0;
+  } else {
+    remaining = carryUs * TICKS_PER_US;
+    carryUs = 0;
+  }
+}
+
+// Applies the steps that are due and sets the compare for the next one,
+// relative to the previous target so the sequence does not drift
+void ActuatorSequencer::onTimer() {
+  while (running) {
+    if (remaining > 0) {
+      uint32_t chunk = (remaining > MAX_CHUNK) ? MAX_CHUNK : remaining;
+      target += chunk;
+      remaining -= chunk;
+      setCompare(target);
+      if ((int16_t)(target - timerCount()) > 0) return;
+
+      // passed while it was written: handle it here, not once more from the interrupt
+      TC4->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+      continue;
+    }
+
+    if (!nextStep()) break;
+    schedule(steps[stepIndex].delayUs);
+  }
+  TC4->COUNT16.INTENCLR.reg = TC_INTENCLR_MC0;
+}
+
+void ActuatorSequencer::poll() {
+  // the timer does the work
+}
+
+#else
+
+void ActuatorSequencer::schedule(uint32_t delayUs) {
+  due += delayUs;
+}
+
+void ActuatorSequencer::onTimer() {
+  // no timer here, see poll()
+}
+
+void ActuatorSequencer::poll() {
+  while (running && ((int32_t)(micros() - due) >= 0)) {
+    if (nextStep()) schedule(steps[stepIndex].delayUs);
+  }
+}
+
+#endif
@@ -0,0 +1,143 @@
+/*
+
+  ActuatorSequencer: timeline of actuator patterns, run from a hardware timer
+
+  A sequence is a table of steps; each step sets the outputs selected by
+  its mask to its pattern, delayUs after the previous step (the first one
+  delayUs after start()). Bit n of a pattern is pins[n].
+
+    const ActuatorStep cycle[] = {
+      // delayUs  pattern  mask
+      {       0,  0b0010,  0x0F },  // valve A
+      { 1500000,  0b0100,  0x0F },  // valve B
+      { 1500000,  0b1000,  0x0F },  // valve C
+      { 1500000,  0b0001,  0x0F },  // pump
+      { 1500000,  0b0000,  0x00 },  // wait, then repeat
+    };
+
+    const uint8_t pins[] = { pump, valveA, valveB, valveC };
+    ActuatorSequencer sequencer(pins, 4);
+
+    sequencer.begin();
+    sequencer.start(cycle, 5, true);  // returns at once, loop() is free
+
+  By default every changed output is a digitalWrite(); with an
+  OutputGroup as writer a step switches all its outputs at once:
+
+    typedef OutputGroup<pump, valveA, valveB, valveC> Actuators;
+    sequencer.setOutputWriter(Actuators::update);
+
+  On the SAMD21 the steps are applied from the TC4 compare interrupt,
+  3 MHz ticks (GCLK0 / 16): the step times are exact to a third of a
+  microsecond plus the interrupt latency, independent of loop(). Steps
+  are scheduled against the previous step's target, not against the
+  moment the interrupt ran, so long sequences do not drift. Delays
+  beyond the 16-bit compare range are split in chunks. A step closer
+  than MIN_DELAY_US to the previous one is applied in the same
+  interrupt and its delay is carried over to the next step: a table of
+  short delays keeps its cycle time instead of spinning in the
+  interrupt. TC4 is also used by the Servo library, they cannot be
+  combined.
+
+  Elsewhere poll() runs the sequence from micros(), as often as loop()
+  calls it.
+
+  The step table is read from the interrupt: it must stay in place (and
+  unchanged) while the sequence runs.
+
+*/
+
+#ifndef ACTUATORSEQUENCER_H
+#define ACTUATORSEQUENCER_H
+
+#include <Arduino.h>
+
+#define ACTUATOR_MAX_OUTPUTS 8
+
+struct ActuatorStep {
+  uint32_t delayUs;  // after the previous step
+  uint8_t pattern;
+  uint8_t mask;      // outputs this step changes
+};
+
+class ActuatorSequencer {
+public:
+
+  // Writes the outputs selected by mask at once, e.g. OutputGroup<...>::update
+  typedef void (*OutputWriter)(uint8_t pattern, uint8_t mask);
+
+  static const uint8_t MIN_DELAY_US = 4;
+
+  ActuatorSequencer(const uint8_t *pins, uint8_t count);
+
+  // Pins to OUTPUT, all off, timer set up
+  void begin();
+
+  // Replaces the per-pin digitalWrite() by one call per step, NULL to go back
+  void setOutputWriter(OutputWriter writer) {
+    this->writer = writer;
+  }
+
+  // Starts a sequence from its first step, false if steps is empty (or
+  // repeats with less than MIN_DELAY_US per step on average)
+  bool start(const ActuatorStep *steps, uint8_t count, bool repeat = false);
+
+  // Stops the sequence and sets all outputs to pattern (off by default)
+  void stop(uint8_t pattern = 0);
+
+  // Sets outputs now, outside of a sequence
+  void set(uint8_t pattern, uint8_t mask = 0xFF);
+
+  bool isRunning() {
+    return running;
+  }
+
+  uint8_t getPattern() {
+    return pattern;
+  }
+
+  // Index of the next step to be applied
+  uint8_t getStepIndex() {
+    return stepIndex;
+  }
+
+  // Number of times a repeating sequence wrapped around
+  uint32_t getCycles() {
+    return cycles;
+  }
+
+  // Runs the sequence from micros() where there is no timer, no-op on the SAMD21
+  void poll();
+
+  // From the TC4 interrupt
+  void onTimer();
+
+private:
+
+  const uint8_t *pins;
+  uint8_t count;
+  OutputWriter writer;
+
+  const ActuatorStep *steps;
+  uint8_t stepCount;
+  bool repeat;
+
+  volatile bool running;
+  volatile uint8_t pattern;
+  volatile uint8_t stepIndex;
+  volatile uint32_t cycles;
+
+#if defined(ARDUINO_ARCH_SAMD)
+  uint16_t target;        // compare value of the next interrupt
+  uint32_t remaining;     // ticks still to go after target
+  uint32_t carryUs;       // sub-MIN_DELAY_US delays not waited for yet
+#else
+  uint32_t due;           // micros() of the next step
+#endif
+
+  void apply(uint8_t pattern, uint8_t mask);
+  bool nextStep();        // applies the current step, false at the end of the sequence
+  void schedule(uint32_t delayUs);
+};
+
+#endif // ACTUATORSEQUENCER_H
@@ -0,0 +1,20 @@
+/*
+
+  OutputGroup: register simulation for builds without the SAMD PORT, see OutputGroup.h
+
+*/
+
+#include "OutputGroup.h"
+
+#if !defined(ARDUINO_ARCH_SAMD)
+
+uint32_t OutputGroupMock::dir[2] = { 0, 0 };
+uint32_t OutputGroupMock::out[2] = { 0, 0 };
+OutputGroupMock::WriteHandler OutputGroupMock::handler = 0;
+
+void OutputGroupMock::reset() {
+  dir[0] = dir[1] = 0;
+  out[0] = out[1] = 0;
+}
+
+#endif
@@ -0,0 +1,188 @@
+/*
+
+  OutputGroup: switch a set of output pins in one go, through the PORT registers
+
+  The pins are template parameters; their PORT group and bit are looked
+  up at compile time (DevBoard / Arduino Zero pin map below), so
+
+    typedef OutputGroup<pump, valveA, valveB, valveC> Actuators;  // 6, 5, 7, 9: PA20, PA15, PA21, PA07
+
+    Actuators::begin();
+    Actuators::write(0b0100);  // valve B only
+
+  compiles to one OUTCLR and one OUTSET on the single-cycle IOBUS port:
+  every output that has to go off does so in the same cycle, and one
+  cycle later every output that has to go on. Outputs are never on
+  together unless both patterns have them on (break before make), and
+  the both-off window is one bus cycle (~21 ns at 48 MHz) instead of the
+  microseconds between digitalWrite() calls.
+
+  All pins of a group must be on the same PORT group (checked at compile
+  time), bit n of a pattern is the nth pin.
+
+  Elsewhere the registers are simulated (OutputGroupMock) and every write
+  is recorded, see extras/output_mock.
+
+*/
+
+#ifndef OUTPUTGROUP_H
+#define OUTPUTGROUP_H
+
+#include <stdint.h>
+
+#if defined(ARDUINO_ARCH_SAMD)
+#include <Arduino.h>
+#endif
+
+#define OUTPUT_PA(bit) (bit)
+#define OUTPUT_PB(bit) (32 + (bit))
+
+// Arduino pin -> (group << 5) | bit, the Arduino Zero variant used by the DevBoard
+static constexpr uint8_t outputPortPins[] = {
+  OUTPUT_PA(11), OUTPUT_PA(10), OUTPUT_PA(14), OUTPUT_PA(9),  OUTPUT_PA(8),   //  0 ..  4
+  OUTPUT_PA(15), OUTPUT_PA(20), OUTPUT_PA(21), OUTPUT_PA(6),  OUTPUT_PA(7),   //  5 ..  9
+  OUTPUT_PA(18), OUTPUT_PA(16), OUTPUT_PA(19), OUTPUT_PA(17),                 // 10 .. 13
+  OUTPUT_PA(2),  OUTPUT_PB(8),  OUTPUT_PB(9),  OUTPUT_PA(4),  OUTPUT_PA(5),   // 14 .. 18, A0 .. A4
+  OUTPUT_PB(2),  OUTPUT_PA(22), OUTPUT_PA(23)                                 // 19 .. 21
+};
+
+constexpr uint8_t outputGroupOf(uint8_t pin) {
+  return outputPortPins[pin] >> 5;
+}
+
+constexpr uint32_t outputMaskOf(uint8_t pin) {
+  return (uint32_t) 1 << (outputPortPins[pin] & 31);
+}
+
+constexpr uint32_t outputMaskOf() {
+  return 0;
+}
+
+template <typename... Rest>
+constexpr uint32_t outputMaskOf(uint8_t pin, uint8_t next, Rest... rest) {
+  return outputMaskOf(pin) | outputMaskOf(next, rest...);
+}
+
+constexpr bool outputSameGroup(uint8_t) {
+  return true;
+}
+
+template <typename... Rest>
+constexpr bool outputSameGroup(uint8_t pin, uint8_t next, Rest... rest) {
+  return (outputGroupOf(pin) == outputGroupOf(next)) && outputSameGroup(next, rest...);
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+struct OutputPort {
+  static inline void set(uint8_t group, uint32_t mask) {
+    PORT_IOBUS->Group[group].OUTSET.reg = mask;
+  }
+  static inline void clear(uint8_t group, uint32_t mask) {
+    PORT_IOBUS->Group[group].OUTCLR.reg = mask;
+  }
+  static inline void output(uint8_t group, uint32_t mask) {
+    PORT_IOBUS->Group[group].DIRSET.reg = mask;
+  }
+  static inline uint32_t read(uint8_t group) {
+    return PORT_IOBUS->Group[group].OUT.reg;
+  }
+};
+
+#else
+
+// Simulated PORT registers, every write is passed to the handler
+struct OutputGroupMock {
+  enum Register {
+    DIRSET = 'D',
+    OUTSET = 'S',
+    OUTCLR = 'C'
+  };
+
+  typedef void (*WriteHandler)(Register reg, uint8_t group, uint32_t mask, uint32_t out);
+
+  static uint32_t dir[2];
+  static uint32_t out[2];
+  static WriteHandler handler;
+
+  static void reset();
+};
+
+struct OutputPort {
+  static inline void set(uint8_t group, uint32_t mask) {
+    OutputGroupMock::out[group] |= mask;
+    if (OutputGroupMock::handler) OutputGroupMock::handler(OutputGroupMock::OUTSET, group, mask, OutputGroupMock::out[group]);
+  }
+  static inline void clear(uint8_t group, uint32_t mask) {
+    OutputGroupMock::out[group] &= ~mask;
+    if (OutputGroupMock::handler) OutputGroupMock::handler(OutputGroupMock::OUTCLR, group, mask, OutputGroupMock::out[group]);
+  }
+  static inline void output(uint8_t group, uint32_t mask) {
+    OutputGroupMock::dir[group] |= mask;
+    if (OutputGroupMock::handler) OutputGroupMock::handler(OutputGroupMock::DIRSET, group, mask, OutputGroupMock::out[group]);
+  }
+  static inline uint32_t read(uint8_t group) {
+    return OutputGroupMock::out[group];
+  }
+};
+
+#endif
+
+template <uint8_t First, uint8_t... Rest>
+class OutputGroup {
+public:
+
+  static_assert(outputSameGroup(First, Rest...), "all pins of an OutputGroup must be on the same PORT group");
+  static_assert(sizeof...(Rest) < 8, "an OutputGroup has at most 8 pins");
+
+  static constexpr uint8_t COUNT = 1 + sizeof...(Rest);
+  static constexpr uint8_t GROUP = outputGroupOf(First);
+  static constexpr uint32_t MASK = outputMaskOf(First, Rest...);
+
+  // All pins off, then outputs
+  static void begin() {
+    OutputPort::clear(GROUP, MASK);
+    OutputPort::output(GROUP, MASK);
+  }
+
+  // Sets all pins of the group to pattern
+  static void write(uint8_t pattern) {
+    uint32_t on = toPort(pattern);
+    OutputPort::clear(GROUP, MASK & ~on);
+    OutputPort::set(GROUP, on);
+  }
+
+  // Sets only the pins selected by mask
+  static void update(uint8_t pattern, uint8_t mask) {
+    OutputPort::clear(GROUP, toPort(~pattern & mask));
+    OutputPort::set(GROUP, toPort(pattern & mask));
+  }
+
+  // Pattern as currently driven
+  static uint8_t read() {
+    uint32_t out = OutputPort::read(GROUP);
+    uint8_t pattern = 0;
+    for (uint8_t i = 0; i < COUNT; i++) {
+      if (out & bits()[i]) pattern |= 1 << i;
+    }
+    return pattern;
+  }
+
+  // Pattern to PORT bits, a few cycles per pin before anything is written
+  static uint32_t toPort(uint8_t pattern) {
+    uint32_t port = 0;
+    for (uint8_t i = 0; i < COUNT; i++) {
+      if (pattern & (1 << i)) port |= bits()[i];
+    }
+    return port;
+  }
+
+private:
+
+  static const uint32_t *bits() {
+    static const uint32_t table[COUNT] = { outputMaskOf(First), outputMaskOf(Rest)... };
+    return table;
+  }
+};
+
+#endif // OUTPUTGROUP_H
@@ -0,0 +1,105 @@
+/*
+
+  SafetyTimer: a check function called from a timer interrupt, see SafetyTimer.h
+
+*/
+
+#include "SafetyTimer.h"
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+#define TICKS_PER_US 3 // GCLK0 48 MHz / 16
+
+static SafetyTimer *timerOwner = NULL;
+
+static inline void syncTC3() {
+  while (TC3->COUNT16.STATUS.bit.SYNCBUSY);
+}
+
+void TC3_Handler() {
+  TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  if (timerOwner != NULL) timerOwner->onTimer();
+}
+
+#endif
+
+SafetyTimer::SafetyTimer() {
+  check = NULL;
+  periodUs = 0;
+  runs = 0;
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+bool SafetyTimer::begin(uint32_t periodUs, Check check) {
+  if ((periodUs < MIN_PERIOD_US) || (periodUs > MAX_PERIOD_US) || (check == NULL)) return false;
+  this->periodUs = periodUs;
+  this->check = check;
+  timerOwner = this;
+
+  GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TCC2_TC3;
+  while (GCLK->STATUS.bit.SYNCBUSY);
+  PM->APBCMASK.reg |= PM_APBCMASK_TC3;
+
+  TC3->COUNT16.CTRLA.reg = TC_CTRLA_SWRST;
+  while (TC3->COUNT16.CTRLA.bit.SWRST);
+
+  // MFRQ: the counter restarts at CC0, one match per period
+  TC3->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV16;
+  syncTC3();
+  TC3->COUNT16.CC[0].reg = (uint16_t)(periodUs * TICKS_PER_US - 1);
+  syncTC3();
+
+  TC3->COUNT16.INTFLAG.reg = TC_INTFLAG_MC0;
+  TC3->COUNT16.INTENSET.reg = TC_INTENSET_MC0;
+  NVIC_SetPriority(TC3_IRQn, 0);
+  NVIC_EnableIRQ(TC3_IRQn);
+
+  TC3->COUNT16.CTRLA.bit.ENABLE = 1;
+  syncTC3();
+  return true;
+}
+
+void SafetyTimer::end() {
+  TC3->COUNT16.INTENCLR.reg = TC_INTENCLR_MC0;
+  TC3->COUNT16.CTRLA.bit.ENABLE = 0;
+  syncTC3();
+  check = NULL;
+}
+
+void SafetyTimer::onTimer() {
+  runs++;
+  if (check != NULL) check();
+}
+
+void SafetyTimer::poll() {
+  // the timer does the work
+}
+
+#else
+
+bool SafetyTimer::begin(uint32_t periodUs, Check check) {
+  if ((periodUs < MIN_PERIOD_US) || (periodUs > MAX_PERIOD_US) || (check == NULL)) return false;
+  this->periodUs = periodUs;
+  this->check = check;
+  due = micros() + periodUs;
+  return true;
+}
+
+void SafetyTimer::end() {
+  check = NULL;
+}
+
+void SafetyTimer::onTimer() {
+  // no timer here, see poll()
+}
+
+void SafetyTimer::poll() {
+  if ((check != NULL) && ((int32_t)(micros() - due) >= 0)) {
+    due = micros() + periodUs;
+    runs++;
+    check();
+  }
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+
+  SafetyTimer: a check function called from a timer interrupt, independent of loop()
+
+  For interlocks that must act while loop() is stuck, e.g. in a TwoWire
+  call on a hanging bus (the SAMD core waits for the bus without a
+  timeout, but with interrupts enabled):
+
+    void safetyTick() {
+      interlock.checkStale(micros());   // trips the outputs from here
+    }
+
+    SafetyTimer safety;
+    safety.begin(500, safetyTick);      // every 500 us
+
+  On the SAMD21 the function runs from the TC3 match interrupt at the
+  highest priority, 3 MHz ticks (GCLK0 / 16): periods of MIN_PERIOD_US up
+  to MAX_PERIOD_US. It runs at most one period after any moment, as long
+  as interrupts are not masked; keep what it shares with loop() short
+  under noInterrupts(). TC3 is free in the Arduino Zero core (TC4: Servo
+  and ActuatorSequencer, TC5: tone()).
+
+  Elsewhere poll() calls the function from micros(), as often as loop()
+  calls it: no guarantee there.
+
+*/
+
+#ifndef SAFETYTIMER_H
+#define SAFETYTIMER_H
+
+#include <Arduino.h>
+
+class SafetyTimer {
+public:
+
+  typedef void (*Check)();
+
+  static const uint32_t MIN_PERIOD_US = 10;
+  static const uint32_t MAX_PERIOD_US = 21845; // 16-bit counter at 3 MHz
+
+  SafetyTimer();
+
+  // False if the period is out of range; one SafetyTimer per sketch (TC3)
+  bool begin(uint32_t periodUs, Check check);
+  void end();
+
+  uint32_t getPeriod() {
+    return periodUs;
+  }
+
+  // Calls so far
+  uint32_t getRuns() {
+    return runs;
+  }
+
+  // Calls the check from micros() where there is no timer, no-op on the SAMD21
+  void poll();
+
+  // From the TC3 interrupt
+  void onTimer();
+
+private:
+
+  Check check;
+  uint32_t periodUs;
+  volatile uint32_t runs;
+
+#if !defined(ARDUINO_ARCH_SAMD)
+  uint32_t due;
+#endif
+};
+
+#endif // SAFETYTIMER_H
@@ -0,0 +1,45 @@
+/*
+
+    Pump soft start with ActuatorPWM: 20 kHz PWM on the pump (pin 6),
+    ramps up to 60 % in 2 s, holds for 5 s, ramps down in 1 s, rests 3 s.
+    Valve A (pin 5, same TCC) is held open at 30 % meanwhile.
+
+*/
+
+#include <ActuatorPWM.h>
+
+#define pump   6
+#define valveA 5
+
+ActuatorPWM pumpPWM(pump);
+ActuatorPWM valvePWM(valveA);
+
+void setup() {
+  Serial.begin(115200);
+
+  if (!pumpPWM.begin(20000) || !valvePWM.begin(20000)) {
+    Serial.println("PWM setup failed");
+  }
+  Serial.print("Resolution (steps per period): ");
+  Serial.println(pumpPWM.getResolution());
+
+  valvePWM.setDuty(ActuatorPWM::percent(30));
+}
+
+void loop() {
+  pumpPWM.rampTo(ActuatorPWM::percent(60), 2000);
+  waitFor(7000);
+
+  pumpPWM.rampTo(0, 1000);
+  waitFor(4000);
+}
+
+// The ramps run from the TCC interrupt, this only reports the duty
+void waitFor(unsigned long ms) {
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    pumpPWM.poll(); // only needed where there is no TCC
+    Serial.println(pumpPWM.getDuty());
+    delay(100);
+  }
+}
@@ -0,0 +1,89 @@
+/*
+    output_mock - host check of OutputGroup against the simulated PORT registers.
+
+    Build:
+        g++ -O2 -std=c++11 -I../.. -o output_mock output_mock.cpp ../../OutputGroup.cpp
+
+    For the DevBoard actuator group (pump 6, valve A 5, valve B 7, valve C 9)
+    it checks that
+      * the PORT mask is PA20 | PA15 | PA21 | PA07,
+      * every pattern drives exactly its PORT bits and reads back,
+      * every switch from any pattern to any other is one OUTCLR and one
+        OUTSET, and the state between them only holds outputs that are on
+        in both patterns (break before make).
+    Prints the write trace of the ActuatorTest cycle, exits 1 on a failure.
+*/
+
+#include <stdio.h>
+
+#include "OutputGroup.h"
+
+#define pump   6
+#define valveA 5
+#define valveB 7
+#define valveC 9
+
+typedef OutputGroup<pump, valveA, valveB, valveC> Actuators;
+
+struct Write {
+  OutputGroupMock::Register reg;
+  uint32_t mask;
+  uint32_t out;
+};
+
+static Write writes[8];
+static int nbWrites = 0;
+static bool trace = false;
+
+static void record(OutputGroupMock::Register reg, uint8_t group, uint32_t mask, uint32_t out) {
+  if (nbWrites < 8) writes[nbWrites++] = { reg, mask, out };
+  if (trace) printf("  P%c %s 0x%08X -> OUT 0x%08X\n", 'A' + group,
+                    (reg == OutputGroupMock::OUTSET) ? "OUTSET" : (reg == OutputGroupMock::OUTCLR) ? "OUTCLR" : "DIRSET",
+                    (unsigned) mask, (unsigned) out);
+}
+
+int main() {
+  int failures = 0;
+  const uint32_t expectedMask = (1UL << 20) | (1UL << 15) | (1UL << 21) | (1UL << 7);
+
+  if ((Actuators::MASK != expectedMask) || (Actuators::GROUP != 0)) {
+    printf("FAIL mask 0x%08X group %u\n", (unsigned) Actuators::MASK, Actuators::GROUP);
+    failures++;
+  }
+
+  OutputGroupMock::handler = record;
+  Actuators::begin();
+  if (OutputGroupMock::dir[0] != expectedMask) {
+    printf("FAIL DIR 0x%08X\n", (unsigned) OutputGroupMock::dir[0]);
+    failures++;
+  }
+
+  for (uint8_t from = 0; from < 16; from++) {
+    for (uint8_t to = 0; to < 16; to++) {
+      Actuators::write(from);
+      nbWrites = 0;
+      Actuators::write(to);
+
+      uint32_t both = Actuators::toPort(from & to);
+      bool ok = (nbWrites == 2) && (writes[0].reg == OutputGroupMock::OUTCLR) && (writes[1].reg == OutputGroupMock::OUTSET)
+                && ((writes[0].out & expectedMask) == both)
+                && ((OutputGroupMock::out[0] & expectedMask) == Actuators::toPort(to))
+                && (Actuators::read() == to);
+      if (!ok) {
+        printf("FAIL 0x%X -> 0x%X\n", from, to);
+        failures++;
+      }
+    }
+  }
+
+  printf("ActuatorTest cycle:\n");
+  const uint8_t cycle[] = { 0b0010, 0b0100, 0b1000, 0b0001 };
+  trace = true;
+  for (uint8_t i = 0; i < 4; i++) {
+    printf(" pattern 0x%X\n", cycle[i]);
+    Actuators::write(cycle[i]);
+  }
+
+  printf("%s, %d failure(s)\n", failures ? "FAILED" : "OK", failures);
+  return failures ? 1 : 0;
+}
@@ -14,6 +14,7 @@
 
 #include "AllSensors_DLC.h"
 #include "Arduino.h"
+#include "I2CBus.h"
 
 enum States {busy, ready}; // linked to Status, but in this case separate this state is indicated by the eocPin as well (not just based on status reading)
 
@@ -46,6 +47,10 @@ bool AllSensors_DLC::checkForSensor() {
       Wire should be active...
   */
 
+  if (i2c != nullptr) {
+    return i2c->probe(I2C_ADDRESS) == I2CBus::OK;
+  }
+
   this->bus->beginTransmission(I2C_ADDRESS);
   int error = this->bus->endTransmission();
 
@@ -125,15 +130,38 @@ void AllSensors_DLC::TestReadData() {
 
 }
 
+bool AllSensors_DLC::startMeasurement() {
+  uint8_t command = START_SINGLE;
+
+  if (i2c != nullptr) {
+    return i2c->write(I2C_ADDRESS, &command, 1) == I2CBus::OK;
+  }
+
+  bus->beginTransmission(I2C_ADDRESS);
+  bus->write(command);
+  return bus->endTransmission() == 0;
+}
+
 bool AllSensors_DLC::readData() {
-  bus->requestFrom(I2C_ADDRESS, (uint8_t) READ_LENGTH);
+  bool complete;
+
+  if (i2c != nullptr) {
+    complete = (i2c->read(I2C_ADDRESS, raw_data, READ_LENGTH) == I2CBus::OK);
+  } else {
+    uint8_t received = bus->requestFrom(I2C_ADDRESS, (uint8_t) READ_LENGTH);
 
-  for (int i = 0; i < READ_LENGTH; i++) {
-    // check correct order:
-    raw_data[i] = bus->read();
+    for (int i = 0; i < READ_LENGTH; i++) {
+      // check correct order:
+      raw_data[i] = bus->read();
+    }
+    complete = (received == READ_LENGTH);
   }
 
-  bus->endTransmission();
+  if (!complete) {
+    // keep the last pressure / temperature, raw_data is not a valid frame
+    status = Status::ERROR;
+    return true;
+  }
 
   status = extractStatus();
   raw_p = extractIntegerPressure();
@@ -37,6 +37,8 @@ https://media.digikey.com/pdf/Data%20Sheets/Amphenol%20All%20Sensors%20Corp/DLC%
 #include <Wire.h>
 #pragma once
 
+class I2CBus;
+
 /* From datasheet DLC-L01G-U2
  *  Pressure(in H2O) = 1.24 * (Pout_dig - OSdig / 2^24) * FSS(inH2O)
  *  where OSdig is specified digital offset output from  Performance Characteristics Table
@@ -108,11 +110,13 @@ public:
 private:
 
   static const uint8_t READ_LENGTH = 7; // see datasheet table 1
+  static const uint8_t START_SINGLE = 0xAA;
   
   static constexpr uint16_t FULL_SCALE_REF = (uint16_t) 1 << 14;
 
   
   TwoWire *bus;
+  I2CBus *i2c = nullptr;
   SensorType type;
   uint8_t eocPin;
 
@@ -230,7 +234,23 @@ public:
     this->temperature_unit = temperature_unit;
   }
 
+  // Route reads through an I2CBus (deadline, retries, bus recovery), it must wrap the same TwoWire.
+  void setI2CBus(I2CBus *i2c) {
+    this->i2c = i2c;
+  }
+
+  // Starts one conversion (command 0xAA), EOC goes high when it is done. False if the command was not acknowledged.
+  bool startMeasurement();
+
+  // Returns true on a failed read: sensor error status, or the frame did not come in (status is then ERROR)
   bool readData();
+
+  // Copy the last 7-byte frame (status, pressure, temperature) as read from the sensor, e.g. for DLC_StreamEncoder.
+  void getRawData(uint8_t frame[]) {
+    for (int i = 0; i < READ_LENGTH; i++) {
+      frame[i] = raw_data[i];
+    }
+  }
 };
 
 // We only tested DLC-L01G-U2
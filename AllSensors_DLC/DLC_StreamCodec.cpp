@@ -0,0 +1,129 @@
+/*
+
+  Stream codec for AllSensors DLC sample frames.
+
+  v1.0.0
+
+*/
+
+#include "DLC_StreamCodec.h"
+
+#define FLAG_TEMPERATURE 0x01
+#define FLAG_STATUS      0x02
+#define FLAG_BITS        2
+
+static inline uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static inline uint8_t putVarint(uint32_t value, uint8_t *out) {
+  uint8_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)value | 0x80;
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+// Returns the number of bytes used, 0 if the varint is incomplete or longer than 5 bytes.
+static inline uint8_t getVarint(const uint8_t *in, uint16_t len, uint32_t *value) {
+  uint32_t result = 0;
+  for (uint8_t n = 0; (n < len) && (n < 5); n++) {
+    result |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+    if ((in[n] & 0x80) == 0) {
+      *value = result;
+      return n + 1;
+    }
+  }
+  return 0;
+}
+
+static inline int32_t framePressure(const uint8_t frame[DLC_FRAME_SIZE]) {
+  return ((int32_t)frame[1] << 16) | ((int32_t)frame[2] << 8) | frame[3];
+}
+
+static inline int32_t frameTemperature(const uint8_t frame[DLC_FRAME_SIZE]) {
+  return ((int32_t)frame[4] << 16) | ((int32_t)frame[5] << 8) | frame[6];
+}
+
+DLC_StreamEncoder::DLC_StreamEncoder() {
+  reset();
+}
+
+void DLC_StreamEncoder::reset() {
+  prevStatus = 0;
+  prevPressure = 0;
+  prevTemperature = 0;
+}
+
+uint8_t DLC_StreamEncoder::encode(const uint8_t frame[DLC_FRAME_SIZE], uint8_t out[DLC_CODEC_MAX_SAMPLE_SIZE]) {
+  int32_t pressure = framePressure(frame);
+  int32_t temperature = frameTemperature(frame);
+
+  uint32_t flags = 0;
+  if (frame[0] != prevStatus) flags |= FLAG_STATUS;
+  if (temperature != prevTemperature) flags |= FLAG_TEMPERATURE;
+
+  uint8_t n = putVarint((zigzag(pressure - prevPressure) << FLAG_BITS) | flags, out);
+  if (flags & FLAG_STATUS) {
+    out[n++] = frame[0];
+  }
+  if (flags & FLAG_TEMPERATURE) {
+    n += putVarint(zigzag(temperature - prevTemperature), out + n);
+  }
+
+  prevStatus = frame[0];
+  prevPressure = pressure;
+  prevTemperature = temperature;
+  return n;
+}
+
+DLC_StreamDecoder::DLC_StreamDecoder() {
+  reset();
+}
+
+void DLC_StreamDecoder::reset() {
+  prevStatus = 0;
+  prevPressure = 0;
+  prevTemperature = 0;
+}
+
+uint8_t DLC_StreamDecoder::decode(const uint8_t *in, uint16_t len, uint8_t frame[DLC_FRAME_SIZE]) {
+  uint32_t head;
+  uint8_t n = getVarint(in, len, &head);
+  if (n == 0) return 0;
+
+  uint8_t status = prevStatus;
+  int32_t temperature = prevTemperature;
+
+  if (head & FLAG_STATUS) {
+    if (n >= len) return 0;
+    status = in[n++];
+  }
+  if (head & FLAG_TEMPERATURE) {
+    uint32_t delta;
+    uint8_t used = getVarint(in + n, len - n, &delta);
+    if (used == 0) return 0;
+    n += used;
+    temperature += unzigzag(delta);
+  }
+  int32_t pressure = prevPressure + unzigzag(head >> FLAG_BITS);
+
+  frame[0] = status;
+  frame[1] = (uint8_t)(pressure >> 16);
+  frame[2] = (uint8_t)(pressure >> 8);
+  frame[3] = (uint8_t)pressure;
+  frame[4] = (uint8_t)(temperature >> 16);
+  frame[5] = (uint8_t)(temperature >> 8);
+  frame[6] = (uint8_t)temperature;
+
+  prevStatus = status;
+  prevPressure = pressure;
+  prevTemperature = temperature;
+  return n;
+}
@@ -0,0 +1,61 @@
+/*
+
+  Stream codec for AllSensors DLC sample frames.
+
+  v1.0.0
+
+  Sits between AllSensors_DLC::getRawData() and the FRAM log. A DLC frame is
+  7 bytes: S[7:0] P[23:16] P[15:8] P[7:0] T[23:16] T[15:8] T[7:0].
+  Each frame is encoded as:
+
+    varint( zigzag(P - previous P) << 2 | statusChanged << 1 | temperatureChanged )
+    [status byte]                                  only if statusChanged
+    [varint( zigzag(T - previous T) )]             only if temperatureChanged
+
+  so the status byte is only stored at the start of each run of identical
+  status bytes, and a steady temperature costs nothing. A sample with a small
+  pressure change (|dP| < 16) and unchanged status / temperature is 1 byte.
+
+  The first frame after reset() is coded against an all zero frame, so a
+  stream (or a block of it) can be decoded on its own.
+
+  No Arduino dependency: the decoder also builds on a host
+  to turn FRAM dumps back into frames.
+
+*/
+
+#ifndef DLC_STREAMCODEC_H
+#define DLC_STREAMCODEC_H
+
+#include <stdint.h>
+
+#define DLC_FRAME_SIZE 7
+#define DLC_CODEC_MAX_SAMPLE_SIZE 9 // 4 byte pressure varint + status + 4 byte temperature varint
+
+class DLC_StreamEncoder {
+  public:
+    DLC_StreamEncoder();
+    void reset();
+    // Encodes one frame into out, returns the number of bytes written (1..DLC_CODEC_MAX_SAMPLE_SIZE).
+    uint8_t encode(const uint8_t frame[DLC_FRAME_SIZE], uint8_t out[DLC_CODEC_MAX_SAMPLE_SIZE]);
+
+  private:
+    uint8_t prevStatus;
+    int32_t prevPressure;
+    int32_t prevTemperature;
+};
+
+class DLC_StreamDecoder {
+  public:
+    DLC_StreamDecoder();
+    void reset();
+    // Decodes one frame from in, returns the number of bytes consumed, 0 if len holds no complete sample.
+    uint8_t decode(const uint8_t *in, uint16_t len, uint8_t frame[DLC_FRAME_SIZE]);
+
+  private:
+    uint8_t prevStatus;
+    int32_t prevPressure;
+    int32_t prevTemperature;
+};
+
+#endif // DLC_STREAMCODEC_H
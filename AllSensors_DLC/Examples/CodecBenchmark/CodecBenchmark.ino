@@ -0,0 +1,93 @@
+/*
+
+    Benchmark for DLC_StreamEncoder / DLC_StreamDecoder.
+
+    Encodes a synthetic breathing pressure trace (sine + noise, slowly
+    drifting temperature, occasional busy status) and prints the compression
+    ratio and the encode / decode cost per sample. Run it on the DevBoard
+    (SAMD21, Cortex-M0+ at 48 MHz) to get cycles/sample for that core.
+
+*/
+
+#include <DLC_StreamCodec.h>
+
+#define NB_FRAMES 256
+#define ROUNDS    16
+
+uint8_t frames[NB_FRAMES][DLC_FRAME_SIZE];
+uint8_t encoded[NB_FRAMES * DLC_CODEC_MAX_SAMPLE_SIZE];
+
+DLC_StreamEncoder encoder;
+DLC_StreamDecoder decoder;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  makeFrames();
+  runBenchmark();
+}
+
+void loop() {
+  // nothing to do
+}
+
+void makeFrames() {
+  for (int i = 0; i < NB_FRAMES; i++) {
+    int32_t pressure = 8192000L + (int32_t)(250000.0 * sin(i * 2.0 * PI / 128.0)) + random(-20, 20);
+    int32_t temperature = 6000000L + i / 64;
+    uint8_t status = (i % 100 == 0) ? 0x60 : 0x40; // busy now and then
+
+    frames[i][0] = status;
+    frames[i][1] = pressure >> 16;
+    frames[i][2] = pressure >> 8;
+    frames[i][3] = pressure;
+    frames[i][4] = temperature >> 16;
+    frames[i][5] = temperature >> 8;
+    frames[i][6] = temperature;
+  }
+}
+
+void runBenchmark() {
+  uint32_t nbBytes = 0;
+  unsigned long start = micros();
+  for (int r = 0; r < ROUNDS; r++) {
+    encoder.reset();
+    nbBytes = 0;
+    for (int i = 0; i < NB_FRAMES; i++) {
+      nbBytes += encoder.encode(frames[i], encoded + nbBytes);
+    }
+  }
+  unsigned long encodeTime = micros() - start;
+
+  bool ok = true;
+  uint8_t frame[DLC_FRAME_SIZE];
+  start = micros();
+  for (int r = 0; r < ROUNDS; r++) {
+    decoder.reset();
+    uint32_t pos = 0;
+    for (int i = 0; i < NB_FRAMES; i++) {
+      pos += decoder.decode(encoded + pos, nbBytes - pos, frame);
+    }
+  }
+  unsigned long decodeTime = micros() - start;
+
+  decoder.reset();
+  uint32_t pos = 0;
+  for (int i = 0; i < NB_FRAMES; i++) {
+    pos += decoder.decode(encoded + pos, nbBytes - pos, frame);
+    if (memcmp(frame, frames[i], DLC_FRAME_SIZE) != 0) ok = false;
+  }
+
+  float samples = (float)NB_FRAMES * ROUNDS;
+  Serial.print("Round trip: ");
+  Serial.println(ok ? "OK" : "MISMATCH");
+  Serial.print("Bytes per sample: ");
+  Serial.println((float)nbBytes / NB_FRAMES);
+  Serial.print("Compression ratio: ");
+  Serial.println((float)(NB_FRAMES * DLC_FRAME_SIZE) / nbBytes);
+  Serial.print("Encode cycles/sample: ");
+  Serial.println(encodeTime * (F_CPU / 1000000.0) / samples);
+  Serial.print("Decode cycles/sample: ");
+  Serial.println(decodeTime * (F_CPU / 1000000.0) / samples);
+}
@@ -0,0 +1,179 @@
+/*
+
+  DeviceRegistry: board bring-up from a bus scan, see DeviceRegistry.h
+
+*/
+
+#include "DeviceRegistry.h"
+
+struct KnownDevice {
+  uint8_t address;
+  DeviceRegistry::DeviceType type;
+  uint8_t capabilities;
+  const char *name;
+};
+
+// Same list as printDeviceName() in WireScanner
+static const KnownDevice knownDevices[] = {
+  { 0x25, DeviceRegistry::SDP800_500PA, DeviceRegistry::DIFF_PRESSURE | DeviceRegistry::TEMPERATURE, "Sensirion SDP800-500Pa" },
+  { 0x26, DeviceRegistry::SDP800_501PA, DeviceRegistry::DIFF_PRESSURE | DeviceRegistry::TEMPERATURE, "Sensirion SDP800-501Pa" },
+  { 0x29, DeviceRegistry::DLC_L01G,     DeviceRegistry::PRESSURE | DeviceRegistry::TEMPERATURE,      "DLC-L01G-U2" },
+  { 0x40, DeviceRegistry::SDP610_500PA, DeviceRegistry::DIFF_PRESSURE,                               "Sensirion SDP610-500Pa" },
+  { 0x50, DeviceRegistry::FRAM,         DeviceRegistry::STORAGE,                                     "FRAM" },
+  { 0x51, DeviceRegistry::FRAM,         DeviceRegistry::STORAGE,                                     "FRAM (1M upper half)" },
+};
+
+static const KnownDevice *findKnown(uint8_t address) {
+  for (uint8_t i = 0; i < sizeof(knownDevices) / sizeof(knownDevices[0]); i++) {
+    if (knownDevices[i].address == address) return &knownDevices[i];
+  }
+  return NULL;
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+int8_t DeviceRegistry::addBus(TwoWire *wire, Sercom *sercom, int eocPin, I2CBus *i2c, int framWpPin) {
+  return setBus(scanner.addBus(wire, sercom), wire, eocPin, i2c, framWpPin);
+}
+#endif
+
+int8_t DeviceRegistry::addBus(TwoWire *wire, int eocPin, I2CBus *i2c, int framWpPin) {
+  return setBus(scanner.addBus(wire), wire, eocPin, i2c, framWpPin);
+}
+
+int8_t DeviceRegistry::setBus(int8_t index, TwoWire *wire, int eocPin, I2CBus *i2c, int framWpPin) {
+  if (index >= 0) {
+    buses[index].wire = wire;
+    buses[index].eocPin = eocPin;
+    buses[index].i2c = i2c;
+    buses[index].framWpPin = framWpPin;
+  }
+  return index;
+}
+
+uint8_t DeviceRegistry::discover() {
+  scanner.scan();
+
+  for (uint8_t i = 0; i < deviceCount; i++) {
+    devices[i].present = scanner.isPresent(devices[i].bus, devices[i].address);
+  }
+
+  uint8_t present = 0;
+  for (uint8_t bus = 0; bus < scanner.getBusCount(); bus++) {
+    for (uint8_t address = I2CScanner::FIRST_ADDRESS; address <= I2CScanner::LAST_ADDRESS; address++) {
+      if (!scanner.isPresent(bus, address)) continue;
+
+      const KnownDevice *known = findKnown(address);
+      if (known == NULL) continue;
+      if (lookup(bus, address) != NULL) {
+        present++;
+        continue;
+      }
+      if (deviceCount >= DEVICE_REGISTRY_MAX_DEVICES) continue;
+
+      // not registered if the driver does not start, tried again next discover()
+      void *driver = createDriver(known->type, bus, address);
+      if (driver == NULL) continue;
+      present++;
+
+      Device &device = devices[deviceCount++];
+      device.type = known->type;
+      device.bus = bus;
+      device.address = address;
+      device.capabilities = known->capabilities;
+      if ((known->type == DLC_L01G) && (buses[bus].eocPin >= 0)) device.capabilities |= EOC_PIN;
+      device.present = true;
+      device.name = known->name;
+      device.driver = driver;
+    }
+  }
+  return present;
+}
+
+const DeviceRegistry::Device *DeviceRegistry::find(DeviceType type, uint8_t nth) {
+  for (uint8_t i = 0; i < deviceCount; i++) {
+    if (devices[i].type != type) continue;
+    if (nth == 0) return &devices[i];
+    nth--;
+  }
+  return NULL;
+}
+
+AllSensors_DLC *DeviceRegistry::getDLC(uint8_t nth) {
+  const Device *device = find(DLC_L01G, nth);
+  return (device != NULL) ? static_cast<AllSensors_DLC *>(device->driver) : NULL;
+}
+
+FRAM_MB85RC_I2C *DeviceRegistry::getFRAM(uint8_t nth) {
+  const Device *device = find(FRAM, nth);
+  return (device != NULL) ? static_cast<FRAM_MB85RC_I2C *>(device->driver) : NULL;
+}
+
+SDP8xx *DeviceRegistry::getSDP8xx(uint8_t nth) {
+  for (uint8_t i = 0; i < deviceCount; i++) {
+    if ((devices[i].type != SDP800_500PA) && (devices[i].type != SDP800_501PA)) continue;
+    if (nth == 0) return static_cast<SDP8xx *>(devices[i].driver);
+    nth--;
+  }
+  return NULL;
+}
+
+SDP6x *DeviceRegistry::getSDP6x(uint8_t nth) {
+  const Device *device = find(SDP610_500PA, nth);
+  return (device != NULL) ? static_cast<SDP6x *>(device->driver) : NULL;
+}
+
+const char *DeviceRegistry::nameOf(uint8_t address) {
+  const KnownDevice *known = findKnown(address);
+  return (known != NULL) ? known->name : NULL;
+}
+
+DeviceRegistry::Device *DeviceRegistry::lookup(uint8_t bus, uint8_t address) {
+  for (uint8_t i = 0; i < deviceCount; i++) {
+    if ((devices[i].bus == bus) && (devices[i].address == address)) return &devices[i];
+  }
+  return NULL;
+}
+
+// Allocated once per device at boot, never freed (unless it does not start)
+void *DeviceRegistry::createDriver(DeviceType type, uint8_t bus, uint8_t address) {
+  BusInfo &info = buses[bus];
+
+  switch (type) {
+    case DLC_L01G: {
+      AllSensors_DLC *dlc = new AllSensors_DLC_L01G(info.wire, info.eocPin);
+      if (info.i2c != NULL) dlc->setI2CBus(info.i2c);
+      return dlc;
+    }
+    case SDP800_500PA:
+    case SDP800_501PA: {
+      SDP8xx *sdp = new SDP8xx(info.wire, address);
+      if (info.i2c != NULL) sdp->setI2CBus(info.i2c);
+      return sdp;
+    }
+    case SDP610_500PA: {
+      SDP6x *sdp = new SDP6x(info.wire, SDP6x::RANGE_500PA);
+      if (info.i2c != NULL) sdp->setI2CBus(info.i2c);
+      return sdp;
+    }
+    case FRAM: {
+      FRAM_MB85RC_I2C *fram = new FRAM_MB85RC_I2C(info.wire, address, false, info.framWpPin);
+      if (info.i2c != NULL) fram->setI2CBus(info.i2c);
+      // density from the Device ID: a smaller part must not wrap around
+      if (fram->beginDetect() != 0) {
+        delete fram;
+        return NULL;
+      }
+
+      // 0x50 / 0x51 of a 1M chip are one die: one sleep state
+      uint16_t density = 0;
+      fram->getOneDeviceID(4, &density);
+      Device *sibling = lookup(bus, address ^ 1);
+      if ((density == MB85RC1MT) && (sibling != NULL) && (sibling->type == FRAM) && (sibling->driver != NULL)) {
+        fram->shareSleepState(static_cast<FRAM_MB85RC_I2C *>(sibling->driver));
+      }
+      return fram;
+    }
+    default:
+      return NULL;
+  }
+}
@@ -0,0 +1,131 @@
+/*
+
+  DeviceRegistry: board bring-up from a bus scan
+
+  Scans the registered buses (I2CScanner), matches every address against
+  the devices known on the DevBoard and constructs the driver on the bus
+  it was found on:
+
+    0x25 / 0x26  Sensirion SDP800-500Pa / SDP800-501Pa  SDP8xx
+    0x29         AllSensors DLC-L01G                    AllSensors_DLC_L01G
+    0x40         Sensirion SDP610-500Pa                 SDP6x
+    0x50 / 0x51  FRAM (0x51: upper half of a 1M chip)   FRAM_MB85RC_I2C
+
+  Usage:
+
+    DeviceRegistry devices;
+
+    devices.addBus(&Wire1, SERCOM2, EOC_B);
+    devices.addBus(&Wire2, SERCOM1, EOC_A, &bus2);  // optional I2CBus
+    devices.discover();
+
+    AllSensors_DLC *dlc = devices.getDLC(0);        // first DLC found, or NULL
+    FRAM_MB85RC_I2C *fram = devices.getFRAM(0);
+
+  A FRAM on a bus drives the WP pin passed to addBus(), by default none
+  (FRAM_NO_WP_PIN): the driver's DEFAULT_WP_PIN 13 is W2_SCL on the
+  DevBoard and would take SCL away from Wire2.
+
+  Drivers are allocated once, at the first discover() that finds them; a
+  device that disappears keeps its entry with present == false and gets
+  the same driver back when it returns. A FRAM is sized from its Device
+  ID; one that cannot be identified is not registered (and is tried
+  again at the next discover()).
+
+*/
+
+#ifndef DEVICEREGISTRY_H
+#define DEVICEREGISTRY_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <I2CBus.h>
+#include <I2CScanner.h>
+#include <AllSensors_DLC.h>
+#include <FRAM_MB85RC_I2C.h>
+#include <SDP8xx.h>
+#include <SDP6x.h>
+
+#define DEVICE_REGISTRY_MAX_DEVICES 16
+
+class DeviceRegistry {
+public:
+
+  enum DeviceType {
+    UNKNOWN = 0,
+    SDP800_500PA,
+    SDP800_501PA,
+    DLC_L01G,
+    SDP610_500PA,
+    FRAM
+  };
+
+  enum Capability {
+    PRESSURE      = 0x01, // gage / absolute pressure
+    DIFF_PRESSURE = 0x02,
+    TEMPERATURE   = 0x04,
+    STORAGE       = 0x08,
+    EOC_PIN       = 0x10  // end-of-conversion pin wired
+  };
+
+  struct Device {
+    DeviceType type;
+    uint8_t bus;
+    uint8_t address;
+    uint8_t capabilities;
+    bool present;
+    const char *name;
+    void *driver;       // use the typed getters, NULL if there is no driver for the type
+  };
+
+#if defined(ARDUINO_ARCH_SAMD)
+  int8_t addBus(TwoWire *wire, Sercom *sercom, int eocPin = -1, I2CBus *i2c = NULL, int framWpPin = FRAM_NO_WP_PIN);
+#endif
+  int8_t addBus(TwoWire *wire, int eocPin = -1, I2CBus *i2c = NULL, int framWpPin = FRAM_NO_WP_PIN);
+
+  // Scans and constructs drivers for new devices, returns the number of devices present
+  uint8_t discover();
+
+  uint8_t count() {
+    return deviceCount;
+  }
+
+  const Device &device(uint8_t index) {
+    return devices[index];
+  }
+
+  // The nth device of a type, NULL if there is none
+  const Device *find(DeviceType type, uint8_t nth = 0);
+
+  AllSensors_DLC *getDLC(uint8_t nth = 0);
+  FRAM_MB85RC_I2C *getFRAM(uint8_t nth = 0);
+  SDP8xx *getSDP8xx(uint8_t nth = 0); // SDP800-500Pa and -501Pa
+  SDP6x *getSDP6x(uint8_t nth = 0);
+
+  I2CScanner &getScanner() {
+    return scanner;
+  }
+
+  // Name of a known address, NULL if unknown
+  static const char *nameOf(uint8_t address);
+
+private:
+
+  struct BusInfo {
+    TwoWire *wire;
+    int eocPin;
+    I2CBus *i2c;
+    int framWpPin;
+  };
+
+  I2CScanner scanner;
+  BusInfo buses[I2C_SCANNER_MAX_BUSES];
+  Device devices[DEVICE_REGISTRY_MAX_DEVICES];
+  uint8_t deviceCount = 0;
+
+  int8_t setBus(int8_t index, TwoWire *wire, int eocPin, I2CBus *i2c, int framWpPin);
+  Device *lookup(uint8_t bus, uint8_t address);
+  void *createDriver(DeviceType type, uint8_t bus, uint8_t address);
+};
+
+#endif // DEVICEREGISTRY_H
@@ -0,0 +1,65 @@
+/*
+
+    Board bring-up with DeviceRegistry: one scan of the three buses,
+    drivers constructed on the bus each device was found on.
+
+*/
+
+#include <Wire.h>
+#include "wiring_private.h" // pinPeripheral() function
+#include <DeviceRegistry.h>
+
+// i2c system bus
+#define W0_SCL 21 // PA22 D20 / SDA SERCOM3.0 SERCOM5.0
+#define W0_SDA 20 // PA23 D21 / SCL SERCOM3.1 SERCOM5.1
+
+#define W1_SCL 3 // PA09  D3    SERCOM0.1 SERCOM2.1
+#define W1_SDA 4 // PA08  D4    SERCOM0.0 SERCOM2.0
+#define EOC_B  17
+
+#define W2_SCL 13 // PA17 D13   SERCOM1.1 SERCOM3.1
+#define W2_SDA 11 // PA16 D11   SERCOM1.0 SERCOM3.0
+#define EOC_A  16
+
+TwoWire Wire0(&sercom3, W0_SDA, W0_SCL);
+TwoWire Wire1(&sercom2, W1_SDA, W1_SCL);
+TwoWire Wire2(&sercom1, W2_SDA, W2_SCL);
+
+I2CBus bus1(&Wire1, W1_SDA, W1_SCL, PIO_SERCOM_ALT);
+I2CBus bus2(&Wire2, W2_SDA, W2_SCL, PIO_SERCOM);
+
+DeviceRegistry devices;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  Wire0.begin();
+  bus1.begin();
+  bus2.begin();
+
+  devices.addBus(&Wire0, SERCOM3);
+  devices.addBus(&Wire1, SERCOM2, EOC_B, &bus1);
+  devices.addBus(&Wire2, SERCOM1, EOC_A, &bus2, FRAM_NO_WP_PIN); // FRAM WP tied low, pin 13 is W2_SCL
+  devices.discover();
+
+  for (uint8_t i = 0; i < devices.count(); i++) {
+    const DeviceRegistry::Device &device = devices.device(i);
+    Serial.print("Bus ");
+    Serial.print(device.bus);
+    Serial.print(" 0x");
+    Serial.print(device.address, HEX);
+    Serial.print(" ");
+    Serial.print(device.name);
+    Serial.println(device.driver != NULL ? "" : " (no driver)");
+  }
+}
+
+void loop() {
+  AllSensors_DLC *sensor = devices.getDLC(0);
+  if (sensor != NULL && !sensor->readData()) {
+    Serial.print("pressure: ");
+    Serial.println(sensor->pressure);
+  }
+  delay(500);
+}
@@ -0,0 +1,433 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_Array.cpp
+    @license  BSD (see license.txt)
+
+    Several MB85RC I2C FRAM chips seen as one address space.
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+
+#include "FRAM_Array.h"
+
+#if defined(ARDUINO_ARCH_SAMD)
+#define BUSSTATE_IDLE  1
+#define BUSSTATE_OWNER 2
+#define CMD_READ       2 // acknowledge (ACKACT) and read the next byte
+#define CMD_STOP       3
+
+#define LANE_IDLE    0 // between sub-transfers
+#define LANE_START   1 // waiting for the bus
+#define LANE_SEND    2
+#define LANE_RECEIVE 3
+#define LANE_DONE    4
+#endif
+
+/*========================================================================*/
+/*                            CONSTRUCTORS                                */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    Constructor
+
+    @params[in] layout
+                FRAM_ARRAY_CONCAT or FRAM_ARRAY_STRIPE
+    @params[in] stripeSize
+                Bytes per stripe in FRAM_ARRAY_STRIPE layout
+*/
+/**************************************************************************/
+FRAM_Array::FRAM_Array(uint8_t layout, uint16_t stripeSize)
+{
+		nbChips = 0;
+		smallestChip = 0;
+		this->layout = layout;
+		this->stripeSize = (stripeSize == 0) ? FRAM_ARRAY_DEFAULT_STRIPE : stripeSize;
+#if defined(ARDUINO_ARCH_SAMD)
+		nbLanes = 0;
+#endif
+}
+
+/*========================================================================*/
+/*                           PUBLIC FUNCTIONS                             */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    @brief  Appends a chip to the array. The chip must have been begin()-ed.
+
+    @params[in] chip
+                Initialised FRAM chip
+    @returns
+				0: success
+				7: chip not initialised or of unknown density
+				10: array full
+*/
+/**************************************************************************/
+byte FRAM_Array::addChip(FRAM_MB85RC_I2C *chip)
+{
+	if (nbChips >= FRAM_ARRAY_MAX_CHIPS) return ERROR_10;
+	if (!chip->isReady()) return ERROR_7;
+
+	uint16_t density;
+	chip->getOneDeviceID(4, &density);
+	if (density == 0) return ERROR_7;
+	// density is in kbit, 1M chips are driven as 2 instances of 512K
+	uint32_t size = (uint32_t) min(density, (uint16_t) 512) * 128;
+
+	chips[nbChips] = chip;
+	chipSize[nbChips] = size;
+#if defined(ARDUINO_ARCH_SAMD)
+	chipSercom[nbChips] = NULL;
+	chipLane[nbChips] = 0;
+#endif
+	if ((nbChips == 0) || (size < smallestChip)) smallestChip = size;
+	nbChips++;
+	return ERROR_0;
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+/**************************************************************************/
+/*!
+    @brief  Appends a chip together with the SERCOM of its bus, for
+			concurrent sub-transfers on different buses
+
+    @params[in] chip
+                Initialised FRAM chip
+    @params[in] sercom
+                SERCOM behind the chip's TwoWire, e.g. SERCOM1 for Wire2
+    @returns
+				see addChip(chip)
+*/
+/**************************************************************************/
+byte FRAM_Array::addChip(FRAM_MB85RC_I2C *chip, Sercom *sercom)
+{
+	byte result = FRAM_Array::addChip(chip);
+	if ((result != ERROR_0) || (sercom == NULL)) return result;
+
+	uint8_t lane = 0;
+	while ((lane < nbLanes) && (lanes[lane].sercom != sercom)) lane++;
+	if (lane == nbLanes) {
+		lanes[nbLanes].sercom = sercom;
+		nbLanes++;
+	}
+	chipSercom[nbChips - 1] = sercom;
+	chipLane[nbChips - 1] = lane;
+	return ERROR_0;
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Total number of bytes addressable through the array
+*/
+/**************************************************************************/
+uint32_t FRAM_Array::capacity(void)
+{
+	if (layout == FRAM_ARRAY_STRIPE) {
+		// whole stripes only, so every stripe row is complete
+		return (smallestChip / stripeSize) * stripeSize * nbChips;
+	}
+	uint32_t total = 0;
+	for (uint8_t i = 0; i < nbChips; i++) total += chipSize[i];
+	return total;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads an array of bytes from the array address space
+
+    @params[in] arrayAddr
+                The address to read from
+	@params[in] items
+				number of bytes to read
+	@params[out] values[]
+				array to be filled in by the memory read
+    @returns
+				return code of the first failing chip transfer
+				8 if items is null, 11 if out of range
+*/
+/**************************************************************************/
+byte FRAM_Array::readArray(uint32_t arrayAddr, uint16_t items, uint8_t values[])
+{
+	return FRAM_Array::transfer(arrayAddr, items, values, false);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes an array of bytes to the array address space
+
+    @params[in] arrayAddr
+                The address to write to
+	@params[in] items
+				number of bytes to write
+	@params[in] values[]
+				The array of bytes to write
+    @returns
+				return code of the first failing chip transfer
+				8 if items is null, 11 if out of range
+*/
+/**************************************************************************/
+byte FRAM_Array::writeArray(uint32_t arrayAddr, uint16_t items, uint8_t values[])
+{
+	return FRAM_Array::transfer(arrayAddr, items, values, true);
+}
+
+/*========================================================================*/
+/*                           PRIVATE FUNCTIONS                            */
+/*========================================================================*/
+
+byte FRAM_Array::transfer(uint32_t arrayAddr, uint16_t items, uint8_t values[], boolean write)
+{
+	if (items == 0) return ERROR_8;
+	if ((nbChips == 0) || (arrayAddr + items > FRAM_Array::capacity())) return ERROR_11;
+
+#if defined(ARDUINO_ARCH_SAMD)
+	boolean concurrent = (nbLanes >= 2);
+	for (uint8_t i = 0; i < nbChips; i++) {
+		if (chipSercom[i] == NULL) concurrent = false;
+	}
+	if (concurrent) return FRAM_Array::transferConcurrent(arrayAddr, items, values, write);
+#endif
+
+	byte result = ERROR_0;
+	while ((items > 0) && (result == ERROR_0)) {
+		uint8_t chipNb;
+		uint16_t chipAddr;
+		uint16_t len = FRAM_Array::locate(arrayAddr, items, &chipNb, &chipAddr);
+
+		if (write) {
+			result = chips[chipNb]->writeArray(chipAddr, (byte) len, values);
+		}
+		else {
+			result = chips[chipNb]->readArray(chipAddr, (byte) len, values);
+		}
+		arrayAddr += len;
+		values += len;
+		items -= len;
+	}
+	return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Maps an array address to a chip and chip address
+
+    @returns
+				length of the sub-transfer that stays on that chip, within one
+				stripe and within FRAM_BURST_SIZE
+*/
+/**************************************************************************/
+uint16_t FRAM_Array::locate(uint32_t arrayAddr, uint16_t remaining, uint8_t *chipNb, uint16_t *chipAddr)
+{
+	uint32_t room;
+
+	if (layout == FRAM_ARRAY_STRIPE) {
+		uint32_t stripe = arrayAddr / stripeSize;
+		uint16_t offset = arrayAddr % stripeSize;
+		*chipNb = stripe % nbChips;
+		*chipAddr = (uint16_t)((stripe / nbChips) * stripeSize + offset);
+		room = stripeSize - offset;
+	}
+	else {
+		uint8_t i = 0;
+		while (arrayAddr >= chipSize[i]) {
+			arrayAddr -= chipSize[i];
+			i++;
+		}
+		*chipNb = i;
+		*chipAddr = (uint16_t) arrayAddr;
+		room = chipSize[i] - arrayAddr;
+	}
+
+	uint16_t len = (uint16_t) min(room, (uint32_t) remaining);
+	return min(len, (uint16_t) FRAM_BURST_SIZE);
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+
+/**************************************************************************/
+/*!
+    @brief  Moves the sub-transfers of every bus at the same time
+
+			Round robin over the buses: each pass starts, advances or
+			finishes at most one byte per bus, without waiting.
+
+    @returns
+				return code of the first failing sub-transfer
+*/
+/**************************************************************************/
+byte FRAM_Array::transferConcurrent(uint32_t arrayAddr, uint16_t items, uint8_t values[], boolean write)
+{
+	uint32_t endAddr = arrayAddr + items;
+	byte result = ERROR_0;
+
+	for (uint8_t i = 0; i < nbLanes; i++) {
+		lanes[i].nextAddr = arrayAddr;
+		lanes[i].state = LANE_IDLE;
+	}
+
+	boolean running = true;
+	while (running) {
+		running = false;
+		for (uint8_t i = 0; i < nbLanes; i++) {
+			Lane &lane = lanes[i];
+			byte laneResult = ERROR_0;
+
+			if (lane.state == LANE_IDLE) {
+				if (result == ERROR_0) {
+					laneResult = FRAM_Array::nextSlice(i, arrayAddr, endAddr, values, write);
+				}
+				else {
+					lane.state = LANE_DONE;
+				}
+			}
+			else if (lane.state != LANE_DONE) {
+				laneResult = FRAM_Array::step(lane, write);
+			}
+
+			if (result == ERROR_0) result = laneResult;
+			if (lane.state != LANE_DONE) running = true;
+		}
+	}
+
+	// WP of every written chip is raised once, after all buses are done
+	for (uint8_t i = 0; i < nbChips; i++) chips[i]->finishTransfer();
+	return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Finds and prepares the next sub-transfer of one bus
+
+    @returns
+				return code of prepareTransfer(), 0 when the bus has nothing left
+*/
+/**************************************************************************/
+byte FRAM_Array::nextSlice(uint8_t laneNb, uint32_t arrayAddr, uint32_t endAddr, uint8_t values[], boolean write)
+{
+	Lane &lane = lanes[laneNb];
+
+	while (lane.nextAddr < endAddr) {
+		uint8_t chipNb;
+		uint16_t chipAddr;
+		uint32_t sliceAddr = lane.nextAddr;
+		uint16_t len = FRAM_Array::locate(sliceAddr, (uint16_t)(endAddr - sliceAddr), &chipNb, &chipAddr);
+		lane.nextAddr += len;
+		if (chipLane[chipNb] != laneNb) continue; // another bus moves this one
+
+		byte result = chips[chipNb]->prepareTransfer(chipAddr, len, write, &lane.device, lane.addrBytes, &lane.addrLen);
+		if (result != ERROR_0) {
+			lane.state = LANE_DONE;
+			return result;
+		}
+		lane.chipNb = chipNb;
+		lane.len = len;
+		lane.index = 0;
+		lane.values = values + (sliceAddr - arrayAddr);
+		lane.sliceStart = micros();
+		lane.state = LANE_START;
+		return ERROR_0;
+	}
+
+	lane.state = LANE_DONE;
+	return ERROR_0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Advances the sub-transfer of one bus without blocking
+
+			Write: device address, memory address bytes, data, stop.
+			Read: device address, memory address bytes, repeated start,
+			then one byte per SB, acknowledged but for the last one.
+
+    @returns
+				0, or 2 / 3 on a NACK of the address / data, 14 on a timeout
+*/
+/**************************************************************************/
+byte FRAM_Array::step(Lane &lane, boolean write)
+{
+	SercomI2cm &i2c = lane.sercom->I2CM;
+
+	if (lane.state == LANE_START) {
+		uint8_t busState = i2c.STATUS.bit.BUSSTATE;
+		if ((busState == BUSSTATE_IDLE) || (busState == BUSSTATE_OWNER)) {
+			i2c.ADDR.bit.ADDR = lane.device << 1; // START + address, write
+			lane.state = LANE_SEND;
+		}
+	}
+	else if ((lane.state == LANE_SEND) && i2c.INTFLAG.bit.MB) {
+		// MB is also set on bus error and lost arbitration
+		if (i2c.STATUS.bit.RXNACK || i2c.STATUS.bit.BUSERR || i2c.STATUS.bit.ARBLOST) {
+			FRAM_Array::stop(lane);
+			return (lane.index == 0) ? ERROR_2 : ERROR_3;
+		}
+
+		uint16_t total = lane.addrLen + (write ? lane.len : 0);
+		if (lane.index < lane.addrLen) {
+			i2c.DATA.reg = lane.addrBytes[lane.index++];
+		}
+		else if (lane.index < total) {
+			i2c.DATA.reg = lane.values[lane.index - lane.addrLen];
+			lane.index++;
+		}
+		else if (write) {
+			FRAM_Array::stop(lane);
+			lane.state = LANE_IDLE;
+			return ERROR_0;
+		}
+		else {
+			i2c.ADDR.bit.ADDR = (lane.device << 1) | 1; // repeated START, read
+			lane.index = 0;
+			lane.state = LANE_RECEIVE;
+		}
+	}
+	else if (lane.state == LANE_RECEIVE) {
+		if (i2c.INTFLAG.bit.SB) {
+			lane.values[lane.index++] = i2c.DATA.reg;
+			if (lane.index < lane.len) {
+				i2c.CTRLB.bit.ACKACT = 0;
+				i2c.CTRLB.bit.CMD = CMD_READ;
+				while (i2c.SYNCBUSY.bit.SYSOP);
+			}
+			else {
+				i2c.CTRLB.bit.ACKACT = 1; // NACK the last byte
+				FRAM_Array::stop(lane);
+				lane.state = LANE_IDLE;
+				return ERROR_0;
+			}
+		}
+		else if (i2c.INTFLAG.bit.MB) {
+			// read address NACKed, bus error or lost arbitration
+			FRAM_Array::stop(lane);
+			return ERROR_2;
+		}
+	}
+
+	if ((uint32_t)(micros() - lane.sliceStart) > FRAM_ARRAY_SLICE_TIMEOUT_US) {
+		if (lane.state != LANE_START) FRAM_Array::stop(lane);
+		lane.state = LANE_DONE;
+		return ERROR_14;
+	}
+	return ERROR_0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Ends the transaction on the bus of a lane; the lane is done
+			unless the caller moves it on
+*/
+/**************************************************************************/
+void FRAM_Array::stop(Lane &lane)
+{
+	SercomI2cm &i2c = lane.sercom->I2CM;
+	i2c.CTRLB.bit.CMD = CMD_STOP;
+	while (i2c.SYNCBUSY.bit.SYSOP);
+	lane.state = LANE_DONE;
+}
+
+#endif
@@ -0,0 +1,97 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_Array.h
+    @license  BSD (see license.txt)
+
+    Several MB85RC I2C FRAM chips seen as one address space.
+
+    Chips may sit on different device addresses (MB85RC_ADDRESS_A000..A111)
+    and on different TwoWire buses. Two layouts are supported:
+    - FRAM_ARRAY_CONCAT: chip 0 first, then chip 1, ... (chips may differ in size)
+    - FRAM_ARRAY_STRIPE: consecutive stripes of stripeSize bytes rotate over
+      the chips, so a long log write is spread over every chip and bus.
+      Every chip counts as large as the smallest one.
+
+    A transfer is split into per-chip sub-transfers of at most
+    FRAM_BURST_SIZE bytes. Through the chips' own readArray() /
+    writeArray() they are issued in address order, one after the other.
+
+    On the SAMD21, with every chip added together with the SERCOM of its
+    bus (addChip(chip, SERCOM1)) and at least two different SERCOMs, the
+    array drives the SERCOMs itself: each bus works through its own
+    sub-transfers, all buses at the same time (polled round robin, as in
+    I2CScanner), so a striped transfer over n buses takes about 1/n of
+    the time. This path bypasses TwoWire and I2CBus; a sub-transfer that
+    does not finish within FRAM_ARRAY_SLICE_TIMEOUT_US fails with 14, and
+    after a failure no new sub-transfer is started.
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+#ifndef _FRAM_ARRAY_H_
+#define _FRAM_ARRAY_H_
+
+#include "FRAM_MB85RC_I2C.h"
+
+#define FRAM_ARRAY_MAX_CHIPS 8 // one per A2..A0 combination
+#define FRAM_ARRAY_CONCAT 0
+#define FRAM_ARRAY_STRIPE 1
+#define FRAM_ARRAY_DEFAULT_STRIPE 64
+#define FRAM_ARRAY_SLICE_TIMEOUT_US 20000 // FRAM_BURST_SIZE + 3 bytes at 100 kHz, with margin
+
+class FRAM_Array {
+ public:
+	FRAM_Array(uint8_t layout = FRAM_ARRAY_CONCAT, uint16_t stripeSize = FRAM_ARRAY_DEFAULT_STRIPE);
+
+	byte	addChip(FRAM_MB85RC_I2C *chip);
+#if defined(ARDUINO_ARCH_SAMD)
+	byte	addChip(FRAM_MB85RC_I2C *chip, Sercom *sercom);
+#endif
+	byte	readArray(uint32_t arrayAddr, uint16_t items, uint8_t values[]);
+	byte	writeArray(uint32_t arrayAddr, uint16_t items, uint8_t values[]);
+	uint32_t	capacity(void);
+	uint8_t	chipCount(void) { return nbChips; }
+
+ private:
+	FRAM_MB85RC_I2C *chips[FRAM_ARRAY_MAX_CHIPS];
+	uint32_t	chipSize[FRAM_ARRAY_MAX_CHIPS];
+	uint8_t	nbChips;
+	uint8_t	layout;
+	uint16_t	stripeSize;
+	uint32_t	smallestChip;
+
+	byte	transfer(uint32_t arrayAddr, uint16_t items, uint8_t values[], boolean write);
+	uint16_t	locate(uint32_t arrayAddr, uint16_t remaining, uint8_t *chipNb, uint16_t *chipAddr);
+
+#if defined(ARDUINO_ARCH_SAMD)
+	// One bus of a concurrent transfer
+	struct Lane {
+		Sercom	*sercom;
+		uint8_t	state;
+		uint8_t	chipNb;
+		uint8_t	device;
+		uint8_t	addrBytes[2];
+		byte	addrLen;
+		uint16_t	len;
+		uint16_t	index;		// bytes sent (address bytes included) or received
+		uint8_t	*values;
+		uint32_t	nextAddr;	// the search for the next sub-transfer of this bus resumes here
+		uint32_t	sliceStart;
+	};
+
+	Sercom	*chipSercom[FRAM_ARRAY_MAX_CHIPS];
+	uint8_t	chipLane[FRAM_ARRAY_MAX_CHIPS];
+	Lane	lanes[FRAM_ARRAY_MAX_CHIPS];
+	uint8_t	nbLanes;
+	boolean	allSercom;
+
+	byte	transferConcurrent(uint32_t arrayAddr, uint16_t items, uint8_t values[], boolean write);
+	byte	nextSlice(uint8_t laneNb, uint32_t arrayAddr, uint32_t endAddr, uint8_t values[], boolean write);
+	byte	step(Lane &lane, boolean write);
+	void	stop(Lane &lane);
+#endif
+};
+
+#endif
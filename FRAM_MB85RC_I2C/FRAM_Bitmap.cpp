@@ -0,0 +1,347 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_Bitmap.cpp
+    @license  BSD (see license.txt)
+
+    Bitmap stored in a region of an MB85RC I2C FRAM.
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+
+#include <string.h>
+#include "FRAM_Bitmap.h"
+
+/*========================================================================*/
+/*                            CONSTRUCTORS                                */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    Constructor
+
+    @params[in] fram
+                Initialised FRAM chip holding the bitmap
+    @params[in] baseAddr
+                FRAM address of the first bitmap byte
+    @params[in] nbBits
+                Number of bits in the bitmap
+    @params[in] mirror
+                Optional RAM copy of FRAM_BITMAP_WORDS(nbBits) words, NULL for none
+*/
+/**************************************************************************/
+FRAM_Bitmap::FRAM_Bitmap(FRAM_MB85RC_I2C *fram, uint16_t baseAddr, uint16_t nbBits, uint32_t *mirror)
+{
+		_fram = fram;
+		this->baseAddr = baseAddr;
+		this->nbBits = nbBits;
+		nbBytes = (nbBits + 7) / 8;
+		_mirror = mirror;
+}
+
+/*========================================================================*/
+/*                           PUBLIC FUNCTIONS                             */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    @brief  Loads the RAM mirror from FRAM (no-op without mirror)
+
+    @returns
+				return code of Wire.endTransmission()
+*/
+/**************************************************************************/
+byte FRAM_Bitmap::begin(void)
+{
+	if (_mirror == NULL) return ERROR_0;
+
+	memset(_mirror, 0, FRAM_BITMAP_WORDS(nbBits) * sizeof(uint32_t));
+	return FRAM_Bitmap::readSpan(0, nbBytes, reinterpret_cast<uint8_t *>(_mirror));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads one bit of the bitmap
+
+    @params[in] bitNb
+                The bit number in the bitmap
+	@params[out] *value
+				value of the bit
+    @returns
+				return code of Wire.endTransmission()
+				return code 9 if bit number is out of the bitmap
+*/
+/**************************************************************************/
+byte FRAM_Bitmap::testBit(uint16_t bitNb, boolean *value)
+{
+	if (bitNb >= nbBits) return ERROR_9;
+
+	if (_mirror != NULL) {
+		*value = (_mirror[bitNb >> 5] >> (bitNb & 31)) & 1;
+		return ERROR_0;
+	}
+
+	uint8_t buffer[1];
+	byte result = _fram->readByte(baseAddr + (bitNb >> 3), buffer);
+	*value = bitRead(buffer[0], bitNb & 7);
+	return result;
+}
+
+byte FRAM_Bitmap::setBit(uint16_t bitNb)
+{
+	return FRAM_Bitmap::applyRange(bitNb, 1, true);
+}
+
+byte FRAM_Bitmap::clearBit(uint16_t bitNb)
+{
+	return FRAM_Bitmap::applyRange(bitNb, 1, false);
+}
+
+byte FRAM_Bitmap::setRange(uint16_t firstBit, uint16_t count)
+{
+	return FRAM_Bitmap::applyRange(firstBit, count, true);
+}
+
+byte FRAM_Bitmap::clearRange(uint16_t firstBit, uint16_t count)
+{
+	return FRAM_Bitmap::applyRange(firstBit, count, false);
+}
+
+byte FRAM_Bitmap::clearAll(void)
+{
+	return FRAM_Bitmap::applyRange(0, nbBits, false);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Finds the lowest bit number holding a 0
+
+	@params[out] *bitNb
+				number of the first cleared bit
+    @returns
+				return code of Wire.endTransmission()
+				return code 12 if every bit is set
+*/
+/**************************************************************************/
+byte FRAM_Bitmap::findFirstZero(uint16_t *bitNb)
+{
+	uint32_t buffer[FRAM_BURST_SIZE / 4];
+	uint16_t offset = 0;
+
+	while (offset < nbBytes) {
+		uint16_t len = min((uint16_t) FRAM_BURST_SIZE, (uint16_t)(nbBytes - offset));
+		uint32_t *words;
+		if (_mirror != NULL) {
+			words = _mirror + (offset >> 2);
+		}
+		else {
+			memset(buffer, 0, sizeof(buffer));
+			byte result = FRAM_Bitmap::readSpan(offset, len, reinterpret_cast<uint8_t *>(buffer));
+			if (result != ERROR_0) return result;
+			words = buffer;
+		}
+
+		uint16_t firstWord = offset >> 2;
+		for (uint16_t i = 0; i < (len + 3) / 4; i++) {
+			uint32_t zeros = ~words[i] & FRAM_Bitmap::validMask(firstWord + i);
+			if (zeros != 0) {
+				*bitNb = ((firstWord + i) << 5) + __builtin_ctzl(zeros);
+				return ERROR_0;
+			}
+		}
+		offset += len;
+	}
+	return ERROR_12;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Counts the bits set in the bitmap
+
+	@params[out] *count
+				number of set bits
+    @returns
+				return code of Wire.endTransmission()
+*/
+/**************************************************************************/
+byte FRAM_Bitmap::popcount(uint16_t *count)
+{
+	uint32_t buffer[FRAM_BURST_SIZE / 4];
+	uint16_t offset = 0;
+	uint16_t total = 0;
+
+	while (offset < nbBytes) {
+		uint16_t len = min((uint16_t) FRAM_BURST_SIZE, (uint16_t)(nbBytes - offset));
+		uint32_t *words;
+		if (_mirror != NULL) {
+			words = _mirror + (offset >> 2);
+		}
+		else {
+			memset(buffer, 0, sizeof(buffer));
+			byte result = FRAM_Bitmap::readSpan(offset, len, reinterpret_cast<uint8_t *>(buffer));
+			if (result != ERROR_0) return result;
+			words = buffer;
+		}
+
+		uint16_t firstWord = offset >> 2;
+		for (uint16_t i = 0; i < (len + 3) / 4; i++) {
+			total += __builtin_popcountl(words[i] & FRAM_Bitmap::validMask(firstWord + i));
+		}
+		offset += len;
+	}
+	*count = total;
+	return ERROR_0;
+}
+
+/*========================================================================*/
+/*                           PRIVATE FUNCTIONS                            */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    @brief  Sets or clears a range of bits
+
+			Only partially covered edge bytes are read back (at most 2 reads),
+			the covered span is written in bursts. With a mirror nothing is
+			read and only the bytes whose value changes are written; the
+			mirror is updated per written run, so it matches FRAM after an
+			I2C error as well.
+
+    @params[in] firstBit
+                first bit of the range
+    @params[in] count
+                number of bits in the range
+    @params[in] value
+                true to set, false to clear
+    @returns
+				return code of Wire.endTransmission()
+				return code 8 if count is null
+				return code 9 if the range exceeds the bitmap
+*/
+/**************************************************************************/
+byte FRAM_Bitmap::applyRange(uint16_t firstBit, uint16_t count, boolean value)
+{
+	if (count == 0) return ERROR_8;
+	if ((firstBit >= nbBits) || (count > nbBits - firstBit)) return ERROR_9;
+
+	uint16_t lastBit = firstBit + count - 1;
+	uint16_t firstByte = firstBit >> 3;
+	uint16_t lastByte = lastBit >> 3;
+	uint8_t headMask = (uint8_t)(0xFF << (firstBit & 7));
+	uint8_t tailMask = (uint8_t)(0xFF >> (7 - (lastBit & 7)));
+	if (firstByte == lastByte) {
+		headMask &= tailMask;
+		tailMask = headMask;
+	}
+
+	byte result;
+	uint8_t buffer[FRAM_BURST_SIZE];
+
+	if (_mirror != NULL) {
+		// Runs of changed bytes only, the mirror follows each run once it is written
+		uint8_t *bytes = reinterpret_cast<uint8_t *>(_mirror);
+		uint16_t runStart = firstByte;
+		uint16_t runLength = 0;
+		for (uint16_t i = firstByte; i <= lastByte + 1; i++) {
+			uint8_t updated = 0;
+			boolean changed = false;
+			if (i <= lastByte) {
+				uint8_t mask = 0xFF;
+				if (i == firstByte) mask &= headMask;
+				if (i == lastByte) mask &= tailMask;
+				updated = value ? (bytes[i] | mask) : (bytes[i] & ~mask);
+				changed = (updated != bytes[i]);
+			}
+			if ((runLength > 0) && (!changed || (runLength == FRAM_BURST_SIZE))) {
+				result = _fram->writeArray(baseAddr + runStart, (byte) runLength, buffer);
+				if (result != ERROR_0) return result;
+				memcpy(bytes + runStart, buffer, runLength);
+				runLength = 0;
+			}
+			if (changed) {
+				if (runLength == 0) runStart = i;
+				buffer[runLength++] = updated;
+			}
+		}
+		return ERROR_0;
+	}
+
+	uint8_t fill = value ? 0xFF : 0x00;
+	uint8_t head = fill;
+	uint8_t tail = fill;
+
+	if (headMask != 0xFF) {
+		result = _fram->readByte(baseAddr + firstByte, &head);
+		if (result != ERROR_0) return result;
+		head = value ? (head | headMask) : (head & ~headMask);
+	}
+	if (firstByte == lastByte) {
+		return _fram->writeByte(baseAddr + firstByte, head);
+	}
+	if (tailMask != 0xFF) {
+		result = _fram->readByte(baseAddr + lastByte, &tail);
+		if (result != ERROR_0) return result;
+		tail = value ? (tail | tailMask) : (tail & ~tailMask);
+	}
+
+	uint16_t offset = firstByte;
+	result = ERROR_0;
+	while ((offset <= lastByte) && (result == ERROR_0)) {
+		uint16_t len = min((uint16_t) FRAM_BURST_SIZE, (uint16_t)(lastByte - offset + 1));
+		memset(buffer, fill, len);
+		if (offset == firstByte) buffer[0] = head;
+		if (offset + len - 1 == lastByte) buffer[len - 1] = tail;
+		result = _fram->writeArray(baseAddr + offset, (byte) len, buffer);
+		offset += len;
+	}
+	return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads len bitmap bytes in FRAM_BURST_SIZE transactions
+*/
+/**************************************************************************/
+byte FRAM_Bitmap::readSpan(uint16_t byteOffset, uint16_t len, uint8_t *dest)
+{
+	byte result = ERROR_0;
+	while ((len > 0) && (result == ERROR_0)) {
+		byte items = (byte) min((uint16_t) FRAM_BURST_SIZE, len);
+		result = _fram->readArray(baseAddr + byteOffset, items, dest);
+		byteOffset += items;
+		dest += items;
+		len -= items;
+	}
+	return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes len bitmap bytes in FRAM_BURST_SIZE transactions
+*/
+/**************************************************************************/
+byte FRAM_Bitmap::writeSpan(uint16_t byteOffset, uint16_t len, uint8_t *src)
+{
+	byte result = ERROR_0;
+	while ((len > 0) && (result == ERROR_0)) {
+		byte items = (byte) min((uint16_t) FRAM_BURST_SIZE, len);
+		result = _fram->writeArray(baseAddr + byteOffset, items, src);
+		byteOffset += items;
+		src += items;
+		len -= items;
+	}
+	return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Mask of the bits of word wordNb that belong to the bitmap
+*/
+/**************************************************************************/
+uint32_t FRAM_Bitmap::validMask(uint16_t wordNb)
+{
+	uint32_t remaining = (uint32_t) nbBits - ((uint32_t) wordNb << 5);
+	return (remaining >= 32) ? 0xFFFFFFFFUL : ((1UL << remaining) - 1);
+}
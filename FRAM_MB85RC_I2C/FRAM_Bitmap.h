@@ -0,0 +1,61 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_Bitmap.h
+    @license  BSD (see license.txt)
+
+    Bitmap stored in a region of an MB85RC I2C FRAM.
+
+    Bit n lives in byte (baseAddr + n / 8), bit position n % 8, which is the
+    same numbering as readBit() / setOneBit() of FRAM_MB85RC_I2C.
+
+    Range operations, find-first-zero and popcount work on whole bytes and
+    32-bit words and move data in bursts of FRAM_BURST_SIZE bytes, instead of
+    one read + one write transaction per bit.
+
+    An optional RAM mirror (one uint32_t per 32 bits) keeps a copy of the
+    bitmap: reads and scans are then served from RAM and updates only write
+    the bytes that changed.
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+#ifndef _FRAM_BITMAP_H_
+#define _FRAM_BITMAP_H_
+
+#include "FRAM_MB85RC_I2C.h"
+
+// Number of uint32_t words a RAM mirror needs for a bitmap of nbBits
+#define FRAM_BITMAP_WORDS(nbBits) (((nbBits) + 31) / 32)
+
+class FRAM_Bitmap {
+ public:
+	FRAM_Bitmap(FRAM_MB85RC_I2C *fram, uint16_t baseAddr, uint16_t nbBits, uint32_t *mirror = NULL);
+
+	byte	begin(void);
+	byte	testBit(uint16_t bitNb, boolean *value);
+	byte	setBit(uint16_t bitNb);
+	byte	clearBit(uint16_t bitNb);
+	byte	setRange(uint16_t firstBit, uint16_t count);
+	byte	clearRange(uint16_t firstBit, uint16_t count);
+	byte	clearAll(void);
+	byte	findFirstZero(uint16_t *bitNb);
+	byte	popcount(uint16_t *count);
+	uint16_t	size(void) { return nbBits; }
+	uint16_t	sizeInBytes(void) { return nbBytes; }
+
+ private:
+	FRAM_MB85RC_I2C *_fram;
+	uint16_t	baseAddr;
+	uint16_t	nbBits;
+	uint16_t	nbBytes;
+	uint32_t	*_mirror;
+
+	byte	applyRange(uint16_t firstBit, uint16_t count, boolean value);
+	byte	readSpan(uint16_t byteOffset, uint16_t len, uint8_t *dest);
+	byte	writeSpan(uint16_t byteOffset, uint16_t len, uint8_t *src);
+	uint32_t	validMask(uint16_t wordNb);
+};
+
+#endif
@@ -0,0 +1,39 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_CRC32.h
+    @license  BSD (see license.txt)
+
+    CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320) for FRAM records.
+
+    On SAMD21 the word-aligned part of a buffer goes through the DSU CRC32
+    engine, the remaining bytes through a table. Everywhere else (other
+    boards, host tools) the table is used for everything, with identical
+    results, so images pulled from the chip can be verified on a PC.
+
+    This file does not depend on Arduino.h so host tools can build it.
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+#ifndef _FRAM_CRC32_H_
+#define _FRAM_CRC32_H_
+
+#include <stdint.h>
+
+#define FRAM_CRC32_SIZE 4 // bytes appended to a block
+#define FRAM_CRC32_INIT 0xFFFFFFFFUL
+
+class FRAM_CRC32 {
+ public:
+	// CRC-32 of a complete buffer (initial value and final inversion included)
+	static uint32_t	compute(const uint8_t *data, uint32_t len);
+	// Running CRC: start from FRAM_CRC32_INIT, invert the end result yourself
+	static uint32_t	update(uint32_t crc, const uint8_t *data, uint32_t len);
+
+ private:
+	static uint32_t	updateTable(uint32_t crc, const uint8_t *data, uint32_t len);
+};
+
+#endif
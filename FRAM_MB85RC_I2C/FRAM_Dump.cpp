@@ -0,0 +1,239 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_Dump.cpp
+    @license  BSD (see license.txt)
+
+    Binary dump / restore of FRAM contents over a Stream.
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+
+#include "FRAM_Dump.h"
+#include "FRAM_CRC32.h"
+
+/*========================================================================*/
+/*                            CONSTRUCTORS                                */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    Constructor
+
+    @params[in] array
+                Memory to dump / restore (one chip is an array of one)
+    @params[in] port
+                Link to the host, e.g. &Serial (native USB on the DevBoard)
+*/
+/**************************************************************************/
+FRAM_Dump::FRAM_Dump(FRAM_Array *array, Stream *port)
+{
+		_array = array;
+		_port = port;
+		rxLength = 0;
+		rxOverflow = false;
+		txLength = 0;
+		txSent = 0;
+}
+
+/*========================================================================*/
+/*                           PUBLIC FUNCTIONS                             */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    @brief  Collects incoming bytes and runs complete commands
+*/
+/**************************************************************************/
+void FRAM_Dump::poll(void)
+{
+	while (_port->available() > 0) {
+		uint8_t c = (uint8_t) _port->read();
+		if (c != 0x00) {
+			// without the 0x00 a valid frame is at most FRAM_DUMP_MAX_COBS - 1
+			// bytes, which decode to at most FRAM_DUMP_MAX_FRAME
+			if (rxLength < FRAM_DUMP_MAX_COBS - 1) {
+				rxBuffer[rxLength++] = c;
+			}
+			else {
+				rxOverflow = true;
+			}
+			continue;
+		}
+
+		if (!rxOverflow && (rxLength > 0)) {
+			uint16_t len = FRAM_DumpProtocol::decode(rxBuffer, rxLength, frame);
+			if (len >= FRAM_DUMP_HEADER_SIZE + FRAM_DUMP_CRC_SIZE) {
+				uint16_t body = len - FRAM_DUMP_CRC_SIZE;
+				if (FRAM_CRC32::compute(frame, body) == FRAM_DumpProtocol::get32(frame + body)) {
+					FRAM_Dump::handleFrame(frame, body);
+				}
+			}
+		}
+		rxLength = 0;
+		rxOverflow = false;
+	}
+}
+
+/**************************************************************************/
+/*!
+    @brief  Streams a memory range as 'D' frames followed by an 'E' frame
+
+			Chunk n + 1 is read while the encoded chunk n drains to the
+			port, see readChunk().
+
+    @params[in] arrayAddr
+                First address to dump
+    @params[in] len
+                Number of bytes to dump
+    @returns
+				0 on success, else the FRAM error that stopped the dump
+				(also reported in the 'E' frame)
+*/
+/**************************************************************************/
+byte FRAM_Dump::dump(uint32_t arrayAddr, uint32_t len)
+{
+	uint32_t imageCrc = FRAM_CRC32_INIT;
+	uint32_t addr = arrayAddr;
+	uint32_t remaining = len;
+	byte result = ERROR_0;
+
+	uint16_t chunk = (uint16_t) min(remaining, (uint32_t) FRAM_DUMP_CHUNK);
+	if (chunk > 0) result = FRAM_Dump::readChunk(addr, chunk);
+
+	while ((remaining > 0) && (result == ERROR_0)) {
+		imageCrc = FRAM_CRC32::update(imageCrc, frame + FRAM_DUMP_HEADER_SIZE, chunk);
+		// encoded into txBuffer: frame is free for the next chunk
+		FRAM_Dump::queueFrame(frame, FRAM_DUMP_DATA, addr, chunk);
+
+		addr += chunk;
+		remaining -= chunk;
+
+		chunk = (uint16_t) min(remaining, (uint32_t) FRAM_DUMP_CHUNK);
+		if (chunk > 0) result = FRAM_Dump::readChunk(addr, chunk);
+	}
+
+	uint8_t *payload = frame + FRAM_DUMP_HEADER_SIZE;
+	FRAM_DumpProtocol::put32(payload, len);
+	FRAM_DumpProtocol::put32(payload + 4, ~imageCrc);
+	payload[8] = result;
+	FRAM_Dump::sendFrame(frame, FRAM_DUMP_END, arrayAddr, 9);
+	return result;
+}
+
+/*========================================================================*/
+/*                           PRIVATE FUNCTIONS                            */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    @brief  Runs one decoded and CRC-checked command frame
+*/
+/**************************************************************************/
+void FRAM_Dump::handleFrame(uint8_t *data, uint16_t len)
+{
+	uint32_t addr = FRAM_DumpProtocol::get32(data + 1);
+	uint8_t *payload = data + FRAM_DUMP_HEADER_SIZE;
+	uint16_t payloadLen = len - FRAM_DUMP_HEADER_SIZE;
+
+	switch (data[0]) {
+		case FRAM_DUMP_CMD_INFO:
+			FRAM_Dump::sendFrame(frame, FRAM_DUMP_CMD_INFO, _array->capacity(), 0);
+			break;
+		case FRAM_DUMP_CMD_READ:
+			if (payloadLen >= 4) {
+				FRAM_Dump::dump(addr, FRAM_DumpProtocol::get32(payload));
+			}
+			break;
+		case FRAM_DUMP_CMD_WRITE:
+			{
+				byte result = ERROR_8;
+				if (payloadLen > 0) result = _array->writeArray(addr, payloadLen, payload);
+				frame[FRAM_DUMP_HEADER_SIZE] = result;
+				FRAM_Dump::sendFrame(frame, FRAM_DUMP_ACK, addr, 1);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads one chunk into the frame payload in FRAM_DUMP_READ_PIECE
+			transactions, topping up the port after each one
+
+	@returns
+				0 on success, else the FRAM error of the failing piece
+*/
+/**************************************************************************/
+byte FRAM_Dump::readChunk(uint32_t arrayAddr, uint16_t len)
+{
+	uint8_t *payload = frame + FRAM_DUMP_HEADER_SIZE;
+	byte result = ERROR_0;
+
+	for (uint16_t done = 0; (done < len) && (result == ERROR_0); done += FRAM_DUMP_READ_PIECE) {
+		uint16_t piece = min((uint16_t)(len - done), (uint16_t) FRAM_DUMP_READ_PIECE);
+		result = _array->readArray(arrayAddr + done, piece, payload + done);
+		FRAM_Dump::drainFrame();
+	}
+	return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sends a frame whose payload is in place, completely
+*/
+/**************************************************************************/
+void FRAM_Dump::sendFrame(uint8_t *data, uint8_t type, uint32_t addr, uint16_t payloadLen)
+{
+	FRAM_Dump::queueFrame(data, type, addr, payloadLen);
+	FRAM_Dump::flushFrame();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Completes header and CRC of a frame whose payload is in place
+			and COBS encodes it into txBuffer, after the previous frame
+			has been written out
+*/
+/**************************************************************************/
+void FRAM_Dump::queueFrame(uint8_t *data, uint8_t type, uint32_t addr, uint16_t payloadLen)
+{
+	FRAM_Dump::flushFrame();
+
+	uint16_t body = FRAM_DUMP_HEADER_SIZE + payloadLen;
+	data[0] = type;
+	FRAM_DumpProtocol::put32(data + 1, addr);
+	FRAM_DumpProtocol::put32(data + body, FRAM_CRC32::compute(data, body));
+
+	txLength = FRAM_DumpProtocol::encode(data, body + FRAM_DUMP_CRC_SIZE, txBuffer);
+	txSent = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes as much of the queued frame as the port takes without blocking
+*/
+/**************************************************************************/
+void FRAM_Dump::drainFrame(void)
+{
+	int room = _port->availableForWrite();
+	if ((room <= 0) || (txSent >= txLength)) return;
+
+	uint16_t n = min((uint16_t)(txLength - txSent), (uint16_t) room);
+	txSent += _port->write(txBuffer + txSent, n);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes the rest of the queued frame, blocking
+*/
+/**************************************************************************/
+void FRAM_Dump::flushFrame(void)
+{
+	if (txSent < txLength) _port->write(txBuffer + txSent, txLength - txSent);
+	txSent = txLength;
+}
@@ -0,0 +1,61 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_Dump.h
+    @license  BSD (see license.txt)
+
+    Binary dump / restore of FRAM contents over a Stream (native USB CDC on
+    the SAMD21), see FRAM_DumpProtocol.h for the framing and
+    extras/fram_dump for the Linux tool that talks to it.
+
+    Call poll() from loop(). Nothing else may print to the same port while
+    a transfer runs; the host skips anything that is not a valid frame.
+
+    A dump overlaps FRAM reads with USB writes: once a 'D' frame is
+    encoded, the next chunk is read in FRAM_DUMP_READ_PIECE transactions
+    and after each one as much of the encoded frame is written as the
+    port takes without blocking (availableForWrite()). The rest is
+    written before the next frame is encoded. Smaller pieces mean more
+    of the USB transfer hidden behind I2C, at 3 extra address bytes per
+    piece on the bus.
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+#ifndef _FRAM_DUMP_H_
+#define _FRAM_DUMP_H_
+
+#include "FRAM_Array.h"
+#include "FRAM_DumpProtocol.h"
+
+#define FRAM_DUMP_READ_PIECE 64 // FRAM bytes per transaction between two USB top-ups
+
+class FRAM_Dump {
+ public:
+	FRAM_Dump(FRAM_Array *array, Stream *port);
+
+	void	poll(void);
+	byte	dump(uint32_t arrayAddr, uint32_t len);
+
+ private:
+	FRAM_Array *_array;
+	Stream *_port;
+
+	uint8_t	rxBuffer[FRAM_DUMP_MAX_COBS];
+	uint16_t	rxLength;
+	boolean	rxOverflow;
+	uint8_t	frame[FRAM_DUMP_MAX_FRAME];
+	uint8_t	txBuffer[FRAM_DUMP_MAX_COBS];
+	uint16_t	txLength;
+	uint16_t	txSent;
+
+	void	handleFrame(uint8_t *data, uint16_t len);
+	byte	readChunk(uint32_t arrayAddr, uint16_t len);
+	void	sendFrame(uint8_t *data, uint8_t type, uint32_t addr, uint16_t payloadLen);
+	void	queueFrame(uint8_t *data, uint8_t type, uint32_t addr, uint16_t payloadLen);
+	void	drainFrame(void);
+	void	flushFrame(void);
+};
+
+#endif
@@ -0,0 +1,117 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_DumpProtocol.h
+    @license  BSD (see license.txt)
+
+    Framing shared by FRAM_Dump (firmware) and extras/fram_dump (host tool).
+
+    Every frame is  [type][32-bit address][payload...][CRC-32]  (little
+    endian), the CRC covering type, address and payload. Frames are COBS
+    encoded and terminated by 0x00, so a receiver resynchronises on the next
+    0x00 after any garbage (e.g. debug prints) and drops frames whose CRC
+    does not match.
+
+    Host -> device
+    - 'I' address unused              : device answers 'I', address = capacity
+    - 'R' address, payload = length   : device streams 'D' frames then 'E'
+    - 'W' address, payload = data     : device writes data, answers 'A'
+    Device -> host
+    - 'D' address, payload = up to FRAM_DUMP_CHUNK bytes of memory
+    - 'E' address = start, payload = length, CRC-32 of the range, status
+    - 'A' address, payload = status (0 = ok, else FRAM error code)
+
+    No Arduino dependency, so the host tool includes it as is.
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+#ifndef _FRAM_DUMPPROTOCOL_H_
+#define _FRAM_DUMPPROTOCOL_H_
+
+#include <stdint.h>
+
+#define FRAM_DUMP_CMD_INFO	'I'
+#define FRAM_DUMP_CMD_READ	'R'
+#define FRAM_DUMP_CMD_WRITE	'W'
+#define FRAM_DUMP_DATA		'D'
+#define FRAM_DUMP_END		'E'
+#define FRAM_DUMP_ACK		'A'
+
+#define FRAM_DUMP_CHUNK 128		// memory bytes per 'D' / 'W' frame
+#define FRAM_DUMP_HEADER_SIZE 5	// type + address
+#define FRAM_DUMP_CRC_SIZE 4
+#define FRAM_DUMP_MAX_FRAME (FRAM_DUMP_HEADER_SIZE + FRAM_DUMP_CHUNK + FRAM_DUMP_CRC_SIZE)
+#define FRAM_DUMP_MAX_COBS (FRAM_DUMP_MAX_FRAME + FRAM_DUMP_MAX_FRAME / 254 + 2) // code bytes + 0x00
+
+class FRAM_DumpProtocol {
+ public:
+	static void	put32(uint8_t *dest, uint32_t value) {
+		dest[0] = (uint8_t) value;
+		dest[1] = (uint8_t)(value >> 8);
+		dest[2] = (uint8_t)(value >> 16);
+		dest[3] = (uint8_t)(value >> 24);
+	}
+
+	static uint32_t	get32(const uint8_t *src) {
+		return (uint32_t) src[0] | ((uint32_t) src[1] << 8) | ((uint32_t) src[2] << 16) | ((uint32_t) src[3] << 24);
+	}
+
+	/**************************************************************************/
+	/*!
+	    @brief  COBS encodes len bytes and appends the 0x00 delimiter
+
+	    @returns    number of bytes written to out (at most len + len / 254 + 2)
+	*/
+	/**************************************************************************/
+	static uint16_t	encode(const uint8_t *in, uint16_t len, uint8_t *out) {
+		uint16_t codePos = 0;
+		uint16_t outPos = 1;
+		uint8_t code = 1;
+
+		for (uint16_t i = 0; i < len; i++) {
+			if (in[i] == 0) {
+				out[codePos] = code;
+				codePos = outPos++;
+				code = 1;
+			}
+			else {
+				out[outPos++] = in[i];
+				code++;
+				if (code == 0xFF) {
+					out[codePos] = code;
+					codePos = outPos++;
+					code = 1;
+				}
+			}
+		}
+		out[codePos] = code;
+		out[outPos++] = 0x00;
+		return outPos;
+	}
+
+	/**************************************************************************/
+	/*!
+	    @brief  Decodes one COBS frame (without its 0x00 delimiter)
+
+	    @returns    number of bytes written to out, 0 on a malformed frame
+	*/
+	/**************************************************************************/
+	static uint16_t	decode(const uint8_t *in, uint16_t len, uint8_t *out) {
+		uint16_t inPos = 0;
+		uint16_t outPos = 0;
+
+		while (inPos < len) {
+			uint8_t code = in[inPos++];
+			if ((code == 0) || (inPos + code - 1 > len)) return 0;
+			for (uint8_t i = 1; i < code; i++) {
+				out[outPos++] = in[inPos++];
+			}
+			if ((code < 0xFF) && (inPos < len)) out[outPos++] = 0x00;
+		}
+		return outPos;
+	}
+};
+
+#endif
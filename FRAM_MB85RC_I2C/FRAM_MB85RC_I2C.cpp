@@ -25,6 +25,8 @@
 #include <stdlib.h>
 #include <Wire.h>
 #include "FRAM_MB85RC_I2C.h"
+#include "FRAM_CRC32.h"
+#include "I2CBus.h"
 
 /*========================================================================*/
 /*                            CONSTRUCTORS                                */
@@ -103,6 +105,7 @@ FRAM_MB85RC_I2C::FRAM_MB85RC_I2C(TwoWire *w, uint8_t address, boolean wp, int pi
 {
 		//This constructor provides capability for chips without the device IDs implemented
 		this->_wire = w;
+		_bus = NULL;
 
 		_framInitialised = false;
 		_manualMode = true;
@@ -110,6 +113,18 @@ FRAM_MB85RC_I2C::FRAM_MB85RC_I2C(TwoWire *w, uint8_t address, boolean wp, int pi
 		wpPin = pin;
 		density = chipDensity;
 
+		_regionCount = 0;
+		_batchDepth = 0;
+		_relock = false;
+
+		_sleeping = false;
+		_sleepSibling = NULL;
+		_autoSleepMs = 0;
+		_lastAccess = 0;
+		_sleepCount = 0;
+		_wakeCount = 0;
+		_asleepMs = 0;
+
 		byte result = FRAM_MB85RC_I2C::initWP(wp);	
 		
 }
@@ -132,7 +147,7 @@ void FRAM_MB85RC_I2C::begin(void) {
 			Serial.print("WP pin number ");
 			Serial.println(wpPin, DEC);
 			Serial.print("Write protect management: ");
-			if(MANAGE_WP) {
+			if(FRAM_MB85RC_I2C::managesWP()) {
 				Serial.println("true");
 			}
 			else {
@@ -152,6 +167,79 @@ void FRAM_MB85RC_I2C::begin(void) {
 	return;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Routes array reads and writes through an I2CBus transaction layer
+
+			The bus adds deadlines, retries and bus recovery. It must wrap the
+			TwoWire passed to the constructor. NULL goes back to plain TwoWire.
+
+    @params[in] bus
+                I2CBus of the chip, see I2CBus.h
+*/
+/**************************************************************************/
+void FRAM_MB85RC_I2C::setI2CBus(I2CBus *bus)
+{
+	_bus = bus;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Fast start-up using device IDs cached in the chip itself
+
+			The signature block at signatureAddr is read in one transaction.
+			If it is valid the chip is ready without the MASTER_CODE ID
+			sequence and without the diagnostics of begin(). Otherwise the
+			IDs are read from the chip and the signature block is written
+			for the next boot.
+
+			Only for chips with 16-bit memory addressing (64K and up) and
+			Device ID support. For chips known at compile time, the manual
+			mode constructor + checkDevice() needs no transaction at all.
+
+    @params[in] signatureAddr
+                Address of the FRAM_SIGNATURE_SIZE bytes reserved for the cache
+	@returns
+				0: chip ready
+				7: chip not identified
+				or return code of Wire.endTransmission()
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::beginCached(uint16_t signatureAddr)
+{
+	byte result = FRAM_MB85RC_I2C::readSignature(signatureAddr);
+	if (result == ERROR_0) {
+		_framInitialised = true;
+		return ERROR_0;
+	}
+
+	_manualMode = false;
+	result = FRAM_MB85RC_I2C::checkDevice();
+	if (result != ERROR_0) return result;
+	if ((density < 64) || ((uint32_t) signatureAddr + FRAM_SIGNATURE_SIZE - 1 > maxaddress)) return ERROR_11;
+
+	return FRAM_MB85RC_I2C::writeSignature(signatureAddr);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Identifies the chip from its Device ID, whatever the constructor density
+
+			Leaves manual mode: manufacturer, density and max address come
+			from the chip, so a smaller part than expected is never written
+			past its end. Chips without Device ID support are not identified.
+
+	@returns
+				0: chip ready
+				7: chip not identified
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::beginDetect(void)
+{
+	_manualMode = false;
+	return FRAM_MB85RC_I2C::checkDevice();
+}
+
 /**************************************************************************/
 /*!
     @brief Check if device is connected at address @i2c_addr
@@ -196,18 +284,31 @@ byte FRAM_MB85RC_I2C::checkDevice(void)
                 The array of bytes to write
 	@returns
 				return code of Wire.endTransmission()
+				return code 10 if a protected region is hit outside a write batch
 */
 /**************************************************************************/
 byte FRAM_MB85RC_I2C::writeArray (uint16_t framAddr, byte items, uint8_t values[])
 {
 	if ((framAddr > maxaddress) || ((framAddr + (uint16_t) items - 1) > maxaddress)) return ERROR_11;
 	
+	byte result = FRAM_MB85RC_I2C::unlockWrite(framAddr, items);
+	if (result != ERROR_0) return result;
 	
-	FRAM_MB85RC_I2C::I2CAddressAdapt(framAddr);
-	for (byte i=0; i < items ; i++) {
-		_wire->write(values[i]);
+	if (_bus != NULL) {
+		uint8_t addrBytes[2];
+		byte addrLen = FRAM_MB85RC_I2C::memoryAddress(framAddr, addrBytes);
+		result = FRAM_MB85RC_I2C::busResult(_bus->writeRegister(i2c_addr, addrBytes, addrLen, values, items));
 	}
-	return _wire->endTransmission();
+	else {
+		FRAM_MB85RC_I2C::I2CAddressAdapt(framAddr);
+		for (byte i=0; i < items ; i++) {
+			_wire->write(values[i]);
+		}
+		result = _wire->endTransmission();
+	}
+	
+	FRAM_MB85RC_I2C::relockWrite();
+	return result;
 }
 
 /**************************************************************************/
@@ -247,6 +348,7 @@ byte FRAM_MB85RC_I2C::writeByte (uint16_t framAddr, uint8_t value)
 				array to be filled in by the memory read
     @returns    
 				return code of Wire.endTransmission()
+				return code 14 if fewer bytes came in or the I2CBus gave up
 */
 /**************************************************************************/
 byte FRAM_MB85RC_I2C::readArray (uint16_t framAddr, byte items, uint8_t values[])
@@ -257,18 +359,127 @@ byte FRAM_MB85RC_I2C::readArray (uint16_t framAddr, byte items, uint8_t values[]
 	if (items == 0) {
 		result = ERROR_8; //number of bytes asked to read null
 	}
+	else if (_bus != NULL) {
+		uint8_t addrBytes[2];
+		byte addrLen = FRAM_MB85RC_I2C::memoryAddress(framAddr, addrBytes);
+		result = FRAM_MB85RC_I2C::busResult(_bus->readRegister(i2c_addr, addrBytes, addrLen, values, items));
+	}
 	else {
 		FRAM_MB85RC_I2C::I2CAddressAdapt(framAddr);
 		result = _wire->endTransmission();
 		
-		_wire->requestFrom(i2c_addr, (uint8_t)items);
+		byte received = _wire->requestFrom(i2c_addr, (uint8_t)items);
 		for (byte i=0; i < items; i++) {
 			values[i] = _wire->read();
 		}
+		if ((result == ERROR_0) && (received < items)) result = ERROR_14; //short read, values incomplete
 	}
 	return result;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Writes an array of bytes followed by its CRC-32, in one transaction
+
+			The block takes items + FRAM_CRC32_SIZE bytes in memory.
+
+    @params[in] framAddr
+                The 16-bit address to write to in FRAM memory
+    @params[in] items
+                The number of items to write from the array
+	@params[in] values[]
+                The array of bytes to write
+	@returns
+				return code of Wire.endTransmission()
+				return code 1 if the block does not fit in FRAM_BURST_SIZE
+				return code 10 if a protected region is hit outside a write batch
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::writeArrayCRC (uint16_t framAddr, byte items, uint8_t values[])
+{
+	if ((uint16_t) items + FRAM_CRC32_SIZE > FRAM_BURST_SIZE) return ERROR_1;
+	if ((framAddr > maxaddress) || ((framAddr + (uint16_t) items + FRAM_CRC32_SIZE - 1) > maxaddress)) return ERROR_11;
+
+	uint32_t crc = FRAM_CRC32::compute(values, items);
+
+	byte result = FRAM_MB85RC_I2C::unlockWrite(framAddr, items + FRAM_CRC32_SIZE);
+	if (result != ERROR_0) return result;
+
+	if (_bus != NULL) {
+		uint8_t block[FRAM_BURST_SIZE];
+		uint8_t addrBytes[2];
+		memcpy(block, values, items);
+		memcpy(block + items, &crc, FRAM_CRC32_SIZE);
+		byte addrLen = FRAM_MB85RC_I2C::memoryAddress(framAddr, addrBytes);
+		result = FRAM_MB85RC_I2C::busResult(_bus->writeRegister(i2c_addr, addrBytes, addrLen, block, items + FRAM_CRC32_SIZE));
+	}
+	else {
+		FRAM_MB85RC_I2C::I2CAddressAdapt(framAddr);
+		_wire->write(values, items);
+		_wire->write(reinterpret_cast<uint8_t *>(&crc), FRAM_CRC32_SIZE);
+		result = _wire->endTransmission();
+	}
+
+	FRAM_MB85RC_I2C::relockWrite();
+	return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads a block written by writeArrayCRC() and checks its CRC-32
+
+			Payload and CRC come in with the same read transaction.
+
+    @params[in] framAddr
+                The 16-bit address to read from in FRAM memory
+	@params[in] items
+				number of payload bytes in the block
+	@params[out] values[]
+				array to be filled in by the memory read
+    @returns
+				return code of Wire.endTransmission()
+				return code 1 if the block does not fit in FRAM_BURST_SIZE
+				return code 13 if the CRC does not match
+				return code 14 if fewer bytes came in or the I2CBus gave up
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::readArrayCRC (uint16_t framAddr, byte items, uint8_t values[])
+{
+	if (items == 0) return ERROR_8;
+	if ((uint16_t) items + FRAM_CRC32_SIZE > FRAM_BURST_SIZE) return ERROR_1;
+	if ((framAddr > maxaddress) || ((framAddr + (uint16_t) items + FRAM_CRC32_SIZE - 1) > maxaddress)) return ERROR_11;
+
+	uint32_t stored = 0;
+	uint8_t *crcBytes = reinterpret_cast<uint8_t *>(&stored);
+
+	if (_bus != NULL) {
+		uint8_t block[FRAM_BURST_SIZE];
+		uint8_t addrBytes[2];
+		byte addrLen = FRAM_MB85RC_I2C::memoryAddress(framAddr, addrBytes);
+		byte result = FRAM_MB85RC_I2C::busResult(_bus->readRegister(i2c_addr, addrBytes, addrLen, block, items + FRAM_CRC32_SIZE));
+		if (result != ERROR_0) return result;
+		memcpy(values, block, items);
+		memcpy(crcBytes, block + items, FRAM_CRC32_SIZE);
+	}
+	else {
+		FRAM_MB85RC_I2C::I2CAddressAdapt(framAddr);
+		byte result = _wire->endTransmission();
+		if (result != ERROR_0) return result;
+
+		byte received = _wire->requestFrom(i2c_addr, (uint8_t)(items + FRAM_CRC32_SIZE));
+		for (byte i=0; i < items; i++) {
+			values[i] = _wire->read();
+		}
+		for (byte i=0; i < FRAM_CRC32_SIZE; i++) {
+			crcBytes[i] = _wire->read();
+		}
+		if (received < items + FRAM_CRC32_SIZE) return ERROR_14;
+	}
+
+	if (stored != FRAM_CRC32::compute(values, items)) return ERROR_13;
+	return ERROR_0;
+}
+
 /**************************************************************************/
 /*!
     @brief  Reads one byte from the specified FRAM address
@@ -597,8 +808,8 @@ boolean FRAM_MB85RC_I2C::getWPStatus(void) {
 /**************************************************************************/
 byte FRAM_MB85RC_I2C::enableWP(void) {
 	byte result;
-	if (MANAGE_WP) {
-		digitalWrite(wpPin,HIGH);
+	if (FRAM_MB85RC_I2C::managesWP()) {
+		if (_batchDepth == 0) digitalWrite(wpPin,HIGH); // endWriteBatch() raises it otherwise
 		wpStatus = true;
 		result = ERROR_0;
 	}
@@ -623,7 +834,7 @@ byte FRAM_MB85RC_I2C::enableWP(void) {
 /**************************************************************************/
 byte FRAM_MB85RC_I2C::disableWP() {
 	byte result;
-	if (MANAGE_WP) {
+	if (FRAM_MB85RC_I2C::managesWP()) {
 		digitalWrite(wpPin,LOW);
 		wpStatus = false;
 		result = ERROR_0;
@@ -633,6 +844,96 @@ byte FRAM_MB85RC_I2C::disableWP() {
 	}
 	return result;
 }
+/**************************************************************************/
+/*!
+    @brief  Adds a region that only a write batch may write to
+
+			The WP pin covers the whole chip, regions are kept by the driver.
+			Once a region is defined, WP stays high: writes outside the
+			regions lower it for their own transaction, writes into a region
+			are refused unless they run inside beginWriteBatch() /
+			endWriteBatch(), which lower WP once for the whole batch.
+
+    @params[in]   startAddr
+                  First protected address
+    @params[in]   endAddr
+                  Last protected address (inclusive)
+	@returns
+				  0: success
+				  10: region table full, WP not managed or endAddr < startAddr
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::addProtectedRegion(uint16_t startAddr, uint16_t endAddr) {
+	if (!FRAM_MB85RC_I2C::managesWP() || (endAddr < startAddr) || (_regionCount >= FRAM_WP_REGIONS)) return ERROR_10;
+
+	_regionStart[_regionCount] = startAddr;
+	_regionEnd[_regionCount] = endAddr;
+	_regionCount++;
+	return FRAM_MB85RC_I2C::enableWP();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Removes all protected regions, WP is left as it is
+*/
+/**************************************************************************/
+void FRAM_MB85RC_I2C::clearProtectedRegions(void) {
+	_regionCount = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Checks whether a range overlaps a protected region
+
+    @params[in]   framAddr
+                  First address of the range
+    @params[in]   items
+                  Length of the range
+	@returns
+				  true if any byte of the range is protected
+*/
+/**************************************************************************/
+boolean FRAM_MB85RC_I2C::isProtected(uint16_t framAddr, uint16_t items) {
+	if (items == 0) return false;
+	uint32_t last = (uint32_t) framAddr + items - 1;
+	for (byte i=0; i < _regionCount; i++) {
+		if ((framAddr <= _regionEnd[i]) && (last >= _regionStart[i])) return true;
+	}
+	return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Lowers WP once for a batch of writes, protected regions included
+
+			Batches nest, WP is restored by the outermost endWriteBatch().
+
+	@returns
+				  0: success
+				  10: error, WP not managed
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::beginWriteBatch(void) {
+	if (!FRAM_MB85RC_I2C::managesWP()) return ERROR_10;
+	if ((_batchDepth++ == 0) && wpStatus) digitalWrite(wpPin,LOW);
+	return ERROR_0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Ends a write batch, restores WP after the outermost one
+
+	@returns
+				  0: success
+				  10: error, no batch open
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::endWriteBatch(void) {
+	if (_batchDepth == 0) return ERROR_10;
+	if ((--_batchDepth == 0) && wpStatus) digitalWrite(wpPin,HIGH);
+	return ERROR_0;
+}
+
 /**************************************************************************/
 /*!
     @brief  Erase device by overwriting it to 0x00
@@ -654,10 +955,12 @@ byte FRAM_MB85RC_I2C::eraseDevice(void) {
 			}
 		#endif
 		
+		FRAM_MB85RC_I2C::beginWriteBatch(); // protected regions included
 		while((i < maxaddress) && (result == 0)){
 		  result = FRAM_MB85RC_I2C::writeByte(i, 0x00);
 		  i++;
 		}
+		FRAM_MB85RC_I2C::endWriteBatch();
 		
 	
 		#if defined(SERIAL_DEBUG) && (SERIAL_DEBUG == 1)
@@ -677,6 +980,181 @@ byte FRAM_MB85RC_I2C::eraseDevice(void) {
 }
 
 
+/**************************************************************************/
+/*!
+    @brief  Puts the chip in sleep mode
+
+			Sequence: MASTER_CODE, device address, repeated start, SLEEP_MODE.
+			The next memory access wakes the chip again, see wake().
+			On a 1M chip 0x50 and 0x51 are the same die: both sleep. Two
+			instances on one die must be linked with shareSleepState(),
+			otherwise the other one accesses the sleeping die without the
+			wake-up sequence.
+			Chips without sleep mode NACK the command.
+
+	@returns
+				return code of Wire.endTransmission()
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::sleep(void)
+{
+	if (_sleeping) return ERROR_0;
+
+	byte result;
+	if (_bus != NULL) {
+		uint8_t device = i2c_addr << 1;
+		result = FRAM_MB85RC_I2C::busResult(_bus->writeCommand(MASTER_CODE >> 1, &device, 1, SLEEP_MODE >> 1));
+		if (result != ERROR_0) return result;
+	}
+	else {
+		_wire->beginTransmission(MASTER_CODE >> 1);
+		_wire->write((byte)(i2c_addr << 1));
+		result = _wire->endTransmission(false);
+		if (result != ERROR_0) return result;
+
+		_wire->beginTransmission(SLEEP_MODE >> 1);
+		result = _wire->endTransmission();
+		if (result != ERROR_0) return result;
+	}
+
+	_sleeping = true;
+	_sleepStart = millis();
+	_sleepCount++;
+	if (_sleepSibling != NULL) {
+		_sleepSibling->_sleeping = true;
+		_sleepSibling->_sleepStart = _sleepStart;
+	}
+	return ERROR_0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Enables automatic sleep after idleMs without memory access
+
+    @params[in] idleMs
+                Idle time before poll() puts the chip to sleep, 0 disables
+*/
+/**************************************************************************/
+void FRAM_MB85RC_I2C::setAutoSleep(uint32_t idleMs)
+{
+	_autoSleepMs = idleMs;
+	_lastAccess = millis();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Call from loop(): sleeps once the idle time has passed
+
+	@returns
+				0 or the return code of sleep()
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::poll(void)
+{
+	if ((_autoSleepMs == 0) || _sleeping) return ERROR_0;
+	if ((uint32_t)(millis() - _lastAccess) < _autoSleepMs) return ERROR_0;
+	if ((_sleepSibling != NULL) && ((uint32_t)(millis() - _sleepSibling->_lastAccess) < _autoSleepMs)) return ERROR_0;
+	return FRAM_MB85RC_I2C::sleep();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Return sleep status
+*/
+/**************************************************************************/
+boolean FRAM_MB85RC_I2C::isSleeping(void) {
+	return _sleeping;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sleep statistics since power up
+
+    @params[out] sleeps
+                Number of times the chip was put to sleep
+    @params[out] wakes
+                Number of accesses that had to wake the chip
+    @params[out] asleepMs
+                Total time in sleep mode, including the current period
+*/
+/**************************************************************************/
+void FRAM_MB85RC_I2C::getSleepStats(uint32_t *sleeps, uint32_t *wakes, uint32_t *asleepMs)
+{
+	*sleeps = _sleepCount;
+	*wakes = _wakeCount;
+	*asleepMs = _asleepMs;
+	if (_sleeping) *asleepMs += millis() - _sleepStart;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Links the two instances of one 1M die (0x50 and 0x51)
+
+			Sleeping and waking through either instance then applies to
+			both, and auto sleep waits until both have been idle.
+
+    @params[in] sibling
+                The instance on the other address of the same chip
+*/
+/**************************************************************************/
+void FRAM_MB85RC_I2C::shareSleepState(FRAM_MB85RC_I2C *sibling)
+{
+	_sleepSibling = sibling;
+	if (sibling != NULL) {
+		sibling->_sleepSibling = this;
+		sibling->_sleeping = _sleeping;
+		sibling->_sleepStart = _sleepStart;
+	}
+}
+
+/**************************************************************************/
+/*!
+    @brief  First half of a transfer driven by the caller on the SERCOM
+			(FRAM_Array): range and protection check, wake-up, WP lowered
+			for a write, device and memory address resolved
+
+    @params[in] framAddr
+                The 16-bit address
+	@params[in] items
+				number of bytes to move
+	@params[in] write
+				true for a write
+	@params[out] device
+				7-bit device address of the transaction
+	@params[out] addrBytes[]
+				memory address bytes to send after the device address
+	@params[out] addrLen
+				number of memory address bytes (1 or 2)
+	@returns
+				0: go ahead, call finishTransfer() once the transaction is over
+				8: items null, 10: protected region, 11: out of range
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::prepareTransfer(uint16_t framAddr, uint16_t items, boolean write, uint8_t *device, uint8_t addrBytes[], byte *addrLen)
+{
+	if (items == 0) return ERROR_8;
+	if ((framAddr > maxaddress) || ((framAddr + items - 1) > maxaddress)) return ERROR_11;
+
+	if (write) {
+		byte result = FRAM_MB85RC_I2C::unlockWrite(framAddr, items);
+		if (result != ERROR_0) return result;
+	}
+	*addrLen = FRAM_MB85RC_I2C::memoryAddress(framAddr, addrBytes);
+	*device = i2c_addr;
+	return ERROR_0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Second half of a caller-driven transfer: raises WP again
+			after one or more prepareTransfer() writes
+*/
+/**************************************************************************/
+void FRAM_MB85RC_I2C::finishTransfer(void)
+{
+	FRAM_MB85RC_I2C::relockWrite();
+}
+
 /*========================================================================*/
 /*                           PRIVATE FUNCTIONS                            */
 /*========================================================================*/
@@ -808,32 +1286,7 @@ byte FRAM_MB85RC_I2C::getDeviceIDs(void)
 byte FRAM_MB85RC_I2C::setDeviceIDs(void)
 {
 	if(_manualMode) {
-		switch(density) {
-			case 4:
-				maxaddress = MAXADDRESS_04;
-				break;
-			case 16:
-				maxaddress = MAXADDRESS_16;
-				break;
-			case 64:
-				maxaddress = MAXADDRESS_64;
-				break;
-			case 128:
-				maxaddress = MAXADDRESS_128;
-				break;
-			case 256:
-				maxaddress = MAXADDRESS_256;
-				break;
-			case 512:
-				maxaddress = MAXADDRESS_512;
-				break;
-			case 1024:
-				maxaddress = MAXADDRESS_1024;
-				break;
-			default:
-				maxaddress = 0; /* means error */
-				break;
-		}
+		maxaddress = maxAddressFor(density); /* 0 means error */
 		densitycode = MANUALMODE_DENSITY_ID;
 		productid = MANUALMODE_PRODUCT_ID;
 		manufacturer = MANUALMODE_MANUFACT_ID;
@@ -877,6 +1330,82 @@ byte FRAM_MB85RC_I2C::deviceIDs2Serial(void) {
 	return result;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Restores the device IDs from a signature block in one read
+
+			Reads with 16-bit memory addressing directly, as the density is
+			not known yet.
+
+    @params[in]   signatureAddr
+	@returns
+				  0: IDs restored
+				  7: no valid signature
+				  or return code of Wire.endTransmission()
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::readSignature(uint16_t signatureAddr)
+{
+	uint16_t words[FRAM_SIGNATURE_SIZE / 2];
+	uint8_t *bytes = reinterpret_cast<uint8_t *>(words);
+
+	if (_bus != NULL) {
+		uint8_t addrBytes[2] = { (uint8_t)(signatureAddr >> 8), (uint8_t)(signatureAddr & 0xFF) };
+		byte result = FRAM_MB85RC_I2C::busResult(_bus->readRegister(i2c_addr, addrBytes, 2, bytes, FRAM_SIGNATURE_SIZE));
+		if (result != ERROR_0) return result;
+	}
+	else {
+		_wire->beginTransmission(i2c_addr);
+		_wire->write(signatureAddr >> 8);
+		_wire->write(signatureAddr & 0xFF);
+		byte result = _wire->endTransmission();
+		if (result != ERROR_0) return result;
+
+		if (_wire->requestFrom(i2c_addr, (uint8_t) FRAM_SIGNATURE_SIZE) != FRAM_SIGNATURE_SIZE) return ERROR_7;
+		for (byte i=0; i < FRAM_SIGNATURE_SIZE; i++) {
+			bytes[i] = _wire->read();
+		}
+	}
+
+	/* magic, manufacturer, productid, densitycode, density, check */
+	if ((words[0] != FRAM_SIGNATURE_MAGIC) || (words[5] != FRAM_MB85RC_I2C::signatureCheck(words))) return ERROR_7;
+	if ((words[1] != FUJITSU_MANUFACT_ID) && (words[1] != CYPRESS_MANUFACT_ID)) return ERROR_7;
+	if ((words[4] < 64) || (maxAddressFor(words[4]) == 0)) return ERROR_7;
+
+	manufacturer = words[1];
+	productid = words[2];
+	densitycode = words[3];
+	density = words[4];
+	maxaddress = maxAddressFor(density);
+	return ERROR_0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stores the current device IDs in a signature block
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::writeSignature(uint16_t signatureAddr)
+{
+	uint16_t words[FRAM_SIGNATURE_SIZE / 2] = { FRAM_SIGNATURE_MAGIC, manufacturer, productid, densitycode, density, 0 };
+	words[5] = FRAM_MB85RC_I2C::signatureCheck(words);
+	return FRAM_MB85RC_I2C::writeArray(signatureAddr, FRAM_SIGNATURE_SIZE, reinterpret_cast<uint8_t *>(words));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check word of a signature block, bound to the device address
+*/
+/**************************************************************************/
+uint16_t FRAM_MB85RC_I2C::signatureCheck(uint16_t words[])
+{
+	uint16_t check = 0x5A5A ^ i2c_addr;
+	for (byte i=0; i < (FRAM_SIGNATURE_SIZE / 2) - 1; i++) {
+		check = (uint16_t)((check << 5) | (check >> 11)) ^ words[i];
+	}
+	return check;
+}
+
 /**************************************************************************/
 /*!
     @brief  Init write protect function for class constructor
@@ -895,7 +1424,7 @@ byte FRAM_MB85RC_I2C::deviceIDs2Serial(void) {
 /**************************************************************************/
 byte FRAM_MB85RC_I2C::initWP(boolean wp) {
 	byte result;
-	if (MANAGE_WP) {
+	if (FRAM_MB85RC_I2C::managesWP()) {
 		pinMode(wpPin,OUTPUT);
 		if (wp) {
 			result = FRAM_MB85RC_I2C::enableWP();
@@ -911,6 +1440,82 @@ byte FRAM_MB85RC_I2C::initWP(boolean wp) {
 	return result;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Tells whether the WP pin is driven by this object
+
+			False with MANAGE_WP off or a FRAM_NO_WP_PIN pin: the pin is then
+			never touched, so a pin shared with another peripheral stays free.
+*/
+/**************************************************************************/
+boolean FRAM_MB85RC_I2C::managesWP(void) {
+	return MANAGE_WP && (wpPin != FRAM_NO_WP_PIN);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Lowers WP for one write outside the protected regions
+
+			Nothing to do inside a batch, or without regions (WP then keeps
+			its plain enableWP() / disableWP() meaning).
+
+	@returns
+				  0: write may go ahead
+				  10: range hits a protected region outside a batch
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::unlockWrite(uint16_t framAddr, uint16_t items) {
+	if ((_regionCount == 0) || (_batchDepth > 0)) return ERROR_0;
+	if (FRAM_MB85RC_I2C::isProtected(framAddr, items)) return ERROR_10;
+	if (wpStatus) {
+		digitalWrite(wpPin,LOW);
+		_relock = true;
+	}
+	return ERROR_0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Raises WP again after unlockWrite()
+*/
+/**************************************************************************/
+void FRAM_MB85RC_I2C::relockWrite(void) {
+	if (_relock) {
+		digitalWrite(wpPin,HIGH);
+		_relock = false;
+	}
+}
+
+/**************************************************************************/
+/*!
+    @brief  Wakes the chip from sleep mode
+
+			Sending the device address starts the wake-up (the chip does not
+			acknowledge it), the memory is accessible tREC later.
+*/
+/**************************************************************************/
+void FRAM_MB85RC_I2C::wake(void) {
+	uint32_t start = micros();
+	if (_bus != NULL) {
+		_bus->probeOnce(i2c_addr); // not acknowledged, no retry
+	}
+	else {
+		_wire->beginTransmission(i2c_addr);
+		_wire->endTransmission();
+	}
+
+	_asleepMs += millis() - _sleepStart;
+	_wakeCount++;
+	_sleeping = false;
+	if (_sleepSibling != NULL) {
+		_sleepSibling->_asleepMs += millis() - _sleepSibling->_sleepStart;
+		_sleepSibling->_sleeping = false;
+	}
+
+	uint32_t elapsed = micros() - start;
+	if (elapsed < FRAM_WAKE_US) delayMicroseconds(FRAM_WAKE_US - elapsed);
+}
+
 /**************************************************************************/
 /*!
     @brief 	Adapts the I2C calls (chip address + memory pointer) according to chip datasheet
@@ -920,13 +1525,15 @@ byte FRAM_MB85RC_I2C::initWP(boolean wp) {
 			
 
     @params[in]  address : memory address
-	@param[out]	 none
-	@returns	 void
+	@param[out]	 addrBytes : memory address bytes to send after the device address
+	@returns	 number of memory address bytes (1 or 2)
 */
 /**************************************************************************/
-void FRAM_MB85RC_I2C::I2CAddressAdapt(uint16_t framAddr) {
+byte FRAM_MB85RC_I2C::memoryAddress(uint16_t framAddr, uint8_t addrBytes[]) {
 	
-	uint8_t chipaddress;
+	/* every memory access passes here first */
+	if (_sleeping) FRAM_MB85RC_I2C::wake();
+	_lastAccess = millis();
 	
 	switch(density) {
 		case 4:
@@ -938,23 +1545,43 @@ void FRAM_MB85RC_I2C::I2CAddressAdapt(uint16_t framAddr) {
 			i2c_addr = ((i2c_addr & 0b11111000) | ((framAddr >> 8) & 0b00000111));
 			break;
 		default:
-			chipaddress = i2c_addr;
 			break;
 	}
 	
-	#if defined(SERIAL_DEBUG) && (SERIAL_DEBUG == 1)
+	#if defined(SERIAL_DEBUG) && (SERIAL_DEBUG >= 2)
 		Serial.print("Calculated address 0x");
-		Serial.println(chipaddress, HEX);
+		Serial.println(i2c_addr, HEX);
 	#endif
 	
 	if (density < 64) {
-		_wire->beginTransmission(i2c_addr);
-		_wire->write(framAddr & 0xFF);
-	}
-	else {
-		_wire->beginTransmission(i2c_addr);
-		_wire->write(framAddr >> 8);
-		_wire->write(framAddr & 0xFF);	
+		addrBytes[0] = framAddr & 0xFF;
+		return 1;
 	}
+	addrBytes[0] = framAddr >> 8;
+	addrBytes[1] = framAddr & 0xFF;
+	return 2;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a TwoWire transmission and sends the memory address
+*/
+/**************************************************************************/
+void FRAM_MB85RC_I2C::I2CAddressAdapt(uint16_t framAddr) {
+	
+	uint8_t addrBytes[2];
+	byte addrLen = FRAM_MB85RC_I2C::memoryAddress(framAddr, addrBytes);
+	
+	_wire->beginTransmission(i2c_addr);
+	_wire->write(addrBytes, addrLen);
 	return;
 }
+
+/**************************************************************************/
+/*!
+    @brief  Maps an I2CBus result to the error codes of this library
+*/
+/**************************************************************************/
+byte FRAM_MB85RC_I2C::busResult(uint8_t result) {
+	return (result > ERROR_4) ? ERROR_14 : result;
+}
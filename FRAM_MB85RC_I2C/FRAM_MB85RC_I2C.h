@@ -66,6 +66,7 @@
 #include <Wire.h>
 
 // Enabling debug I2C - comment to disable / normal operations
+// 2 also prints the device address of every transaction (breaks binary links such as FRAM_Dump)
 #ifndef SERIAL_DEBUG
 #define SERIAL_DEBUG 1
 #endif
@@ -103,6 +104,10 @@ enum chip_density{MB85RC04V = 4, MB85RC64TA = 64, MB85RC256V = 256, MB85RC512T =
 #define MAXADDRESS_512 65535
 #define MAXADDRESS_1024 65535 // 1M devices are in fact managed as 2 512 devices from lib point of view > create 2 instances of the object with each a differnt address
 
+// Signature block caching the detected IDs, see beginCached()
+#define FRAM_SIGNATURE_MAGIC 0xF5A3
+#define FRAM_SIGNATURE_SIZE 12
+
 // Adresses
 #define MB85RC_ADDRESS_A000   0x50
 #define MB85RC_ADDRESS_A001   0x51
@@ -116,13 +121,30 @@ enum chip_density{MB85RC04V = 4, MB85RC64TA = 64, MB85RC256V = 256, MB85RC512T =
 
 //Special commands
 #define MASTER_CODE	0xF8
-#define SLEEP_MODE	0x86 //Cypress codes, not used here	
+#define SLEEP_MODE	0x86 //Sleep command, sent after MASTER_CODE + device address, see sleep()
 #define HIGH_SPEED	0x08 //Cypress codes, not used here
 
+// Recovery time from sleep mode (tREC), MB85RC1MT / MB85RC512T / FM24V10
+#define FRAM_WAKE_US 400
+
+// Largest payload moved in a single I2C transaction by the bulk helpers.
+// SAMD: the Wire buffer holds 256 bytes, but writeArray() / readArray() count
+//   items in a byte (255); 128, a power of two inside both limits,
+//   keeps the block buffers on the stack small.
+// AVR: Wire BUFFER_LENGTH (32) minus the 2 memory address bytes, rounded
+//   down to a multiple of 4.
+#if defined(ARDUINO_ARCH_SAMD)
+#define FRAM_BURST_SIZE 128
+#else
+#define FRAM_BURST_SIZE 28
+#endif
+
 // Managing Write protect pin
 #define MANAGE_WP true //false if WP pin remains not connected
 #define DEFAULT_WP_PIN	13 //write protection pin - active high, write enabled when low
+#define FRAM_NO_WP_PIN	-1 //WP not wired to the MCU (tied low on the board), no pin is driven
 #define DEFAULT_WP_STATUS  false //false means protection is off - write is enabled
+#define FRAM_WP_REGIONS 4 //size of the protected region table
 
 // Error management
 #define ERROR_0 0 // Success    
@@ -137,6 +159,11 @@ enum chip_density{MB85RC04V = 4, MB85RC64TA = 64, MB85RC256V = 256, MB85RC512T =
 #define ERROR_9 9 // Bit position out of range
 #define ERROR_10 10 // Not permitted opération
 #define ERROR_11 11 // Memory address out of range
+#define ERROR_12 12 // Nothing found matching the request
+#define ERROR_13 13 // CRC check failed on read
+#define ERROR_14 14 // I2C transaction failed (timeout, short read or stuck bus)
+
+class I2CBus;
 
 
 class FRAM_MB85RC_I2C {
@@ -148,6 +175,9 @@ class FRAM_MB85RC_I2C {
 	FRAM_MB85RC_I2C(TwoWire *w = &Wire, uint8_t address = MB85RC_DEFAULT_ADDRESS, boolean wp = false, int pin = DEFAULT_WP_PIN, uint16_t chipDensity = MB85RC1MT);
 	
 	void	begin(void);
+	void	setI2CBus(I2CBus *bus);
+	byte	beginCached(uint16_t signatureAddr);
+	byte	beginDetect(void);
 	byte	checkDevice(void);
 	byte	readBit(uint16_t framAddr, uint8_t bitNb, byte *bit);
 	byte	setOneBit(uint16_t framAddr, uint8_t bitNb);
@@ -155,6 +185,8 @@ class FRAM_MB85RC_I2C {
 	byte	toggleBit(uint16_t framAddr, uint8_t bitNb);
 	byte	readArray (uint16_t framAddr, byte items, uint8_t value[]);
 	byte	writeArray (uint16_t framAddr, byte items, uint8_t value[]);
+	byte	readArrayCRC (uint16_t framAddr, byte items, uint8_t value[]);
+	byte	writeArrayCRC (uint16_t framAddr, byte items, uint8_t value[]);
 	byte	readByte (uint16_t framAddr, uint8_t *value);
 	byte	writeByte (uint16_t framAddr, uint8_t value);
 	byte	copyByte (uint16_t origAddr, uint16_t destAddr);
@@ -167,11 +199,36 @@ class FRAM_MB85RC_I2C {
 	boolean	getWPStatus(void);
 	byte	enableWP(void);
 	byte	disableWP(void);
+	byte	addProtectedRegion(uint16_t startAddr, uint16_t endAddr);
+	void	clearProtectedRegions(void);
+	boolean	isProtected(uint16_t framAddr, uint16_t items);
+	byte	beginWriteBatch(void);
+	byte	endWriteBatch(void);
 	byte	eraseDevice(void);
+	byte	sleep(void);
+	void	setAutoSleep(uint32_t idleMs);
+	byte	poll(void);
+	boolean	isSleeping(void);
+	void	getSleepStats(uint32_t *sleeps, uint32_t *wakes, uint32_t *asleepMs);
+	void	shareSleepState(FRAM_MB85RC_I2C *sibling);
+	byte	prepareTransfer(uint16_t framAddr, uint16_t items, boolean write, uint8_t *device, uint8_t addrBytes[], byte *addrLen);
+	void	finishTransfer(void);
+
+	// Max address for a density in K, 0 if unsupported. Usable in static_assert() when the chip is known at compile time.
+	static constexpr uint16_t maxAddressFor(uint16_t chipDensity) {
+		return (chipDensity == 4) ? MAXADDRESS_04 :
+			(chipDensity == 16) ? MAXADDRESS_16 :
+			(chipDensity == 64) ? MAXADDRESS_64 :
+			(chipDensity == 128) ? MAXADDRESS_128 :
+			(chipDensity == 256) ? MAXADDRESS_256 :
+			(chipDensity == 512) ? MAXADDRESS_512 :
+			(chipDensity == 1024) ? MAXADDRESS_1024 : 0;
+	}
   
  private:
 	uint8_t	i2c_addr;
 	TwoWire *_wire;
+	I2CBus *_bus;
 
 	boolean	_framInitialised;
 	boolean	_manualMode;
@@ -183,12 +240,35 @@ class FRAM_MB85RC_I2C {
 
 	int	wpPin;
 	boolean	wpStatus;
+	uint16_t	_regionStart[FRAM_WP_REGIONS];
+	uint16_t	_regionEnd[FRAM_WP_REGIONS];
+	byte	_regionCount;
+	byte	_batchDepth;
+	boolean	_relock;
+
+	boolean	_sleeping;
+	FRAM_MB85RC_I2C *_sleepSibling;
+	uint32_t	_autoSleepMs;
+	uint32_t	_lastAccess;
+	uint32_t	_sleepStart;
+	uint32_t	_sleepCount;
+	uint32_t	_wakeCount;
+	uint32_t	_asleepMs;
 
 	byte	getDeviceIDs(void);	
 	byte	setDeviceIDs(void);
 	byte	initWP(boolean wp);
+	boolean	managesWP(void);
+	byte	unlockWrite(uint16_t framAddr, uint16_t items);
+	void	relockWrite(void);
 	byte	deviceIDs2Serial(void);
+	byte	readSignature(uint16_t signatureAddr);
+	byte	writeSignature(uint16_t signatureAddr);
+	uint16_t	signatureCheck(uint16_t words[]);
+	void	wake(void);
+	byte	memoryAddress(uint16_t framAddr, uint8_t addrBytes[]);
 	void	I2CAddressAdapt(uint16_t framAddr);
+	byte	busResult(uint8_t result);
 };
 
 #endif
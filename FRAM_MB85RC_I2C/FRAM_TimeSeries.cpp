@@ -0,0 +1,329 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_TimeSeries.cpp
+    @license  BSD (see license.txt)
+
+    Block structured time-series log on an MB85RC I2C FRAM region.
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+
+#include <string.h>
+#include "FRAM_TimeSeries.h"
+
+#define HEADER_SIZE sizeof(FRAM_TSBlockHeader)
+
+/*========================================================================*/
+/*                            CONSTRUCTORS                                */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    Constructor
+
+    @params[in] fram
+                Initialised FRAM chip holding the log
+    @params[in] baseAddr
+                First FRAM address of the region
+    @params[in] regionSize
+                Bytes in the region (superblock, index and blocks)
+    @params[in] blockSize
+                Bytes per block, header included
+*/
+/**************************************************************************/
+FRAM_TimeSeries::FRAM_TimeSeries(FRAM_MB85RC_I2C *fram, uint16_t baseAddr, uint16_t regionSize, uint16_t blockSize)
+{
+		_fram = fram;
+		this->baseAddr = baseAddr;
+		this->blockSize = blockSize;
+
+		if ((blockSize > HEADER_SIZE) && (regionSize > FRAM_TS_SUPERBLOCK_SIZE)) {
+			nbBlocks = (regionSize - FRAM_TS_SUPERBLOCK_SIZE) / (FRAM_TS_INDEX_ENTRY_SIZE + blockSize);
+		}
+		else {
+			nbBlocks = 0;
+		}
+		indexAddr = baseAddr + FRAM_TS_SUPERBLOCK_SIZE;
+		blocksAddr = indexAddr + nbBlocks * FRAM_TS_INDEX_ENTRY_SIZE;
+
+		blocksWritten = 0;
+		blockOpen = false;
+		memset(&current, 0, sizeof(current));
+}
+
+/*========================================================================*/
+/*                           PUBLIC FUNCTIONS                             */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    @brief  Attaches to the log stored in the region, or formats it
+
+			Without format, a region holding a log with the same block size
+			is reopened and appends continue in its newest block.
+
+    @params[in] format
+                true to discard any previous content
+    @returns
+				return code of Wire.endTransmission()
+				return code 11 if the region cannot hold a single block
+*/
+/**************************************************************************/
+byte FRAM_TimeSeries::begin(boolean format)
+{
+	if (nbBlocks == 0) return ERROR_11;
+
+	byte result;
+	if (!format) {
+		uint32_t superblock[FRAM_TS_SUPERBLOCK_SIZE / 4];
+		result = _fram->readArray(baseAddr, FRAM_TS_SUPERBLOCK_SIZE, reinterpret_cast<uint8_t *>(superblock));
+		if (result != ERROR_0) return result;
+
+		// word 0: magic (low half) + block size (high half), word 1: blocks written
+		format = (superblock[0] != (FRAM_TS_MAGIC | ((uint32_t) blockSize << 16)));
+		blocksWritten = superblock[1];
+	}
+
+	if (format) {
+		blocksWritten = 0;
+		blockOpen = false;
+		return FRAM_TimeSeries::writeSuperblock();
+	}
+
+	blockOpen = false;
+	if (blocksWritten == 0) return ERROR_0;
+
+	result = _fram->readArray(FRAM_TimeSeries::blockAddress(blockCount() - 1), HEADER_SIZE, reinterpret_cast<uint8_t *>(&current));
+	if (result != ERROR_0) return result;
+	if (current.used > blockSize - HEADER_SIZE) current.used = blockSize - HEADER_SIZE;
+	blockOpen = true;
+	return ERROR_0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Appends a record to the log
+
+			Opens a new block when the current one cannot take len more
+			bytes. Opening a block writes its header, index entry and the
+			superblock; a plain append is a single write transaction.
+
+    @params[in] timestamp
+                Time of the record, not lower than the previous one
+    @params[in] data[]
+                Record bytes
+    @params[in] len
+                Number of record bytes
+    @returns
+				return code of Wire.endTransmission()
+				return code 1 if the record is larger than a block
+				return code 10 if the timestamp goes back in time
+*/
+/**************************************************************************/
+byte FRAM_TimeSeries::append(uint32_t timestamp, uint8_t data[], byte len)
+{
+	if (nbBlocks == 0) return ERROR_11;
+	if (len > blockSize - HEADER_SIZE) return ERROR_1;
+	if ((blocksWritten > 0) && (timestamp < current.lastTimestamp)) return ERROR_10;
+
+	byte result;
+	if (FRAM_TimeSeries::room() < len) {
+		result = FRAM_TimeSeries::startBlock();
+		if (result != ERROR_0) return result;
+	}
+
+	if (!blockOpen) {
+		blocksWritten++;
+		current.firstTimestamp = timestamp;
+		current.lastTimestamp = timestamp;
+		current.count = 0;
+		current.used = 0;
+		blockOpen = true;
+
+		uint16_t physical = FRAM_TimeSeries::physicalBlock(blockCount() - 1);
+		result = _fram->writeLong(indexAddr + physical * FRAM_TS_INDEX_ENTRY_SIZE, timestamp);
+		if (result == ERROR_0) result = FRAM_TimeSeries::writeCurrentHeader();
+		if (result == ERROR_0) result = FRAM_TimeSeries::writeSuperblock();
+		if (result != ERROR_0) return result;
+	}
+
+	uint16_t addr = FRAM_TimeSeries::blockAddress(blockCount() - 1) + HEADER_SIZE + current.used;
+	uint8_t done = 0;
+	result = ERROR_0;
+	while ((done < len) && (result == ERROR_0)) {
+		byte items = min((byte) FRAM_BURST_SIZE, (byte)(len - done));
+		result = _fram->writeArray(addr + done, items, data + done);
+		done += items;
+	}
+	if (result != ERROR_0) return result;
+
+	current.lastTimestamp = timestamp;
+	current.count++;
+	current.used += len;
+	return ERROR_0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Closes the current block, the next append() opens a new one
+*/
+/**************************************************************************/
+byte FRAM_TimeSeries::startBlock(void)
+{
+	byte result = FRAM_TimeSeries::flush();
+	blockOpen = false;
+	return result;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes the header of the current block, making it visible after a reset
+*/
+/**************************************************************************/
+byte FRAM_TimeSeries::flush(void)
+{
+	if (!blockOpen) return ERROR_0;
+	return FRAM_TimeSeries::writeCurrentHeader();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Payload bytes that still fit in the current block
+*/
+/**************************************************************************/
+uint16_t FRAM_TimeSeries::room(void)
+{
+	if (!blockOpen) return blockSize - HEADER_SIZE;
+	return blockSize - HEADER_SIZE - current.used;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Finds the block holding a timestamp by binary search on the index
+
+    @params[in] timestamp
+                Time to look for
+	@params[out] *block
+				Newest block starting at or before timestamp (0 = oldest block),
+				0 as well if timestamp is older than the whole log
+    @returns
+				return code of Wire.endTransmission()
+				return code 12 if the log is empty
+*/
+/**************************************************************************/
+byte FRAM_TimeSeries::seek(uint32_t timestamp, uint32_t *block)
+{
+	uint32_t count = FRAM_TimeSeries::blockCount();
+	if (count == 0) return ERROR_12;
+
+	uint32_t low = 0;
+	uint32_t high = count - 1;
+	while (low < high) {
+		uint32_t mid = (low + high + 1) / 2;
+		uint32_t first;
+		byte result = FRAM_TimeSeries::readIndex(mid, &first);
+		if (result != ERROR_0) return result;
+
+		if (first <= timestamp) {
+			low = mid;
+		}
+		else {
+			high = mid - 1;
+		}
+	}
+	*block = low;
+	return ERROR_0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads the header of a block (0 = oldest)
+*/
+/**************************************************************************/
+byte FRAM_TimeSeries::readBlockHeader(uint32_t block, FRAM_TSBlockHeader *header)
+{
+	uint32_t count = FRAM_TimeSeries::blockCount();
+	if (block >= count) return ERROR_11;
+
+	if (blockOpen && (block == count - 1)) {
+		*header = current;
+		return ERROR_0;
+	}
+	return _fram->readArray(FRAM_TimeSeries::blockAddress(block), HEADER_SIZE, reinterpret_cast<uint8_t *>(header));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads payload bytes of a block (0 = oldest)
+
+    @params[in] block
+                Block number
+    @params[in] offset
+                First payload byte to read
+    @params[in] len
+                Number of bytes to read
+	@params[out] dest[]
+				array to be filled in by the memory read
+    @returns
+				return code of Wire.endTransmission()
+				return code 11 if outside the block
+*/
+/**************************************************************************/
+byte FRAM_TimeSeries::readBlockData(uint32_t block, uint16_t offset, byte len, uint8_t dest[])
+{
+	if (block >= FRAM_TimeSeries::blockCount()) return ERROR_11;
+	if (offset + len > blockSize - HEADER_SIZE) return ERROR_11;
+
+	return _fram->readArray(FRAM_TimeSeries::blockAddress(block) + HEADER_SIZE + offset, len, dest);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Number of blocks holding data, the current block included
+*/
+/**************************************************************************/
+uint32_t FRAM_TimeSeries::blockCount(void)
+{
+	return (blocksWritten < nbBlocks) ? blocksWritten : nbBlocks;
+}
+
+/*========================================================================*/
+/*                           PRIVATE FUNCTIONS                            */
+/*========================================================================*/
+
+/**************************************************************************/
+/*!
+    @brief  Maps a block number (0 = oldest) on its slot in the ring
+*/
+/**************************************************************************/
+uint16_t FRAM_TimeSeries::physicalBlock(uint32_t block)
+{
+	if (blocksWritten <= nbBlocks) return (uint16_t) block;
+	return (uint16_t)((blocksWritten - nbBlocks + block) % nbBlocks);
+}
+
+uint16_t FRAM_TimeSeries::blockAddress(uint32_t block)
+{
+	return blocksAddr + FRAM_TimeSeries::physicalBlock(block) * blockSize;
+}
+
+byte FRAM_TimeSeries::writeSuperblock(void)
+{
+	uint32_t superblock[FRAM_TS_SUPERBLOCK_SIZE / 4];
+	superblock[0] = FRAM_TS_MAGIC | ((uint32_t) blockSize << 16);
+	superblock[1] = blocksWritten;
+	return _fram->writeArray(baseAddr, FRAM_TS_SUPERBLOCK_SIZE, reinterpret_cast<uint8_t *>(superblock));
+}
+
+byte FRAM_TimeSeries::writeCurrentHeader(void)
+{
+	return _fram->writeArray(FRAM_TimeSeries::blockAddress(blockCount() - 1), HEADER_SIZE, reinterpret_cast<uint8_t *>(&current));
+}
+
+byte FRAM_TimeSeries::readIndex(uint32_t block, uint32_t *timestamp)
+{
+	return _fram->readLong(indexAddr + FRAM_TimeSeries::physicalBlock(block) * FRAM_TS_INDEX_ENTRY_SIZE, timestamp);
+}
@@ -0,0 +1,80 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_TimeSeries.h
+    @license  BSD (see license.txt)
+
+    Block structured time-series log on an MB85RC I2C FRAM region.
+
+    Region layout:
+    - superblock (8 bytes): magic, block size, number of blocks ever opened
+    - index: one uint32_t per block holding the first timestamp of that block
+    - blocks: FRAM_TSBlockHeader followed by the payload bytes
+
+    Blocks are used as a ring, the oldest one is overwritten once the region
+    is full. Timestamps must not decrease, so seek() is a binary search over
+    the index: a handful of 4-byte reads instead of scanning from address 0.
+
+    Payload is opaque. Streams that are coded relative to the previous
+    sample (e.g. DLC_StreamEncoder) should call startBlock() and reset their
+    encoder when room() gets too small, so each block decodes on its own.
+
+    The header of the block being filled is kept in RAM and written when the
+    block is closed or on flush().
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+#ifndef _FRAM_TIMESERIES_H_
+#define _FRAM_TIMESERIES_H_
+
+#include "FRAM_MB85RC_I2C.h"
+
+#define FRAM_TS_MAGIC 0x5453 // "TS"
+#define FRAM_TS_SUPERBLOCK_SIZE 8
+#define FRAM_TS_INDEX_ENTRY_SIZE 4
+
+typedef struct {
+	uint32_t	firstTimestamp;
+	uint32_t	lastTimestamp;
+	uint16_t	count;	// number of append() calls in the block
+	uint16_t	used;	// payload bytes in the block
+} FRAM_TSBlockHeader;
+
+class FRAM_TimeSeries {
+ public:
+	FRAM_TimeSeries(FRAM_MB85RC_I2C *fram, uint16_t baseAddr, uint16_t regionSize, uint16_t blockSize);
+
+	byte	begin(boolean format = false);
+	byte	append(uint32_t timestamp, uint8_t data[], byte len);
+	byte	startBlock(void);
+	byte	flush(void);
+	uint16_t	room(void);
+
+	byte	seek(uint32_t timestamp, uint32_t *block);
+	byte	readBlockHeader(uint32_t block, FRAM_TSBlockHeader *header);
+	byte	readBlockData(uint32_t block, uint16_t offset, byte len, uint8_t dest[]);
+	uint32_t	blockCount(void);
+	uint16_t	blockCapacity(void) { return nbBlocks; }
+
+ private:
+	FRAM_MB85RC_I2C *_fram;
+	uint16_t	baseAddr;
+	uint16_t	blockSize;
+	uint16_t	nbBlocks;
+	uint16_t	indexAddr;
+	uint16_t	blocksAddr;
+
+	uint32_t	blocksWritten;
+	boolean	blockOpen;
+	FRAM_TSBlockHeader	current;
+
+	uint16_t	physicalBlock(uint32_t block);
+	uint16_t	blockAddress(uint32_t block);
+	byte	writeSuperblock(void);
+	byte	writeCurrentHeader(void);
+	byte	readIndex(uint32_t block, uint32_t *timestamp);
+};
+
+#endif
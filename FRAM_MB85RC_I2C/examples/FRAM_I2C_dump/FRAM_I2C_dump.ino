@@ -0,0 +1,59 @@
+/**************************************************************************/
+/*!
+    @file     FRAM_I2C_dump.ino
+    @license  BSD (see license.txt)
+
+    Serves binary dump / restore of the FRAM over native USB.
+
+    On the PC (see extras/fram_dump):
+        fram_dump read  /dev/ttyACM0 image.bin
+        fram_dump write /dev/ttyACM0 image.bin
+
+    A 1M chip answers on 0x50 and 0x51, both halves are joined in one
+    FRAM_Array so the whole 128 KB comes out in one image.
+
+    Build with SERIAL_DEBUG at 0 or 1, level 2 prints on every transaction.
+
+    @section  HISTORY
+
+    v1.0.0 - First release
+*/
+/**************************************************************************/
+
+#include <Wire.h>
+#include <FRAM_MB85RC_I2C.h>
+#include <FRAM_Array.h>
+#include <FRAM_Dump.h>
+#include "wiring_private.h" // pinPeripheral() function
+
+#define W2_SCL 13 // PA17 D13   SERCOM1.1 SERCOM3.1
+#define W2_SDA 11 // PA16 D11   SERCOM1.0 SERCOM3.0
+
+TwoWire Wire2(&sercom1, W2_SDA, W2_SCL); // EEPROM / SRAM
+
+FRAM_MB85RC_I2C lowerHalf(&Wire2, MB85RC_ADDRESS_A000, false, FRAM_NO_WP_PIN); // pin 13 is W2_SCL
+FRAM_MB85RC_I2C upperHalf(&Wire2, MB85RC_ADDRESS_A001, false, FRAM_NO_WP_PIN);
+
+FRAM_Array memory;
+FRAM_Dump link(&memory, &Serial);
+
+void setup() {
+  Serial.begin(115200); // native USB: baud rate is ignored
+  while (!Serial) ; //wait until Serial ready
+
+  Wire2.begin();
+  Wire2.setClock(1000000); // MB85RC1MT runs up to 3.4 MHz, bus time is the bottleneck of a dump
+
+  // Assign pins 13 & 11 to SERCOM functionality
+  pinPeripheral(W2_SDA, PIO_SERCOM);
+  pinPeripheral(W2_SCL, PIO_SERCOM);
+
+  lowerHalf.begin();
+  upperHalf.begin();
+  memory.addChip(&lowerHalf);
+  memory.addChip(&upperHalf);
+}
+
+void loop() {
+  link.poll();
+}
@@ -0,0 +1,297 @@
+/*
+    fram_dump - Linux host tool for the FRAM_Dump firmware side.
+
+    Build:
+        g++ -O2 -std=c++11 -o fram_dump fram_dump.cpp ../../FRAM_CRC32.cpp
+
+    Usage:
+        fram_dump info  /dev/ttyACM0
+        fram_dump read  /dev/ttyACM0 image.bin [address length]
+        fram_dump write /dev/ttyACM0 image.bin [address]
+
+    read reassembles the 'D' frames into the image, re-requests chunks that
+    were lost or failed their CRC, checks the CRC-32 of the whole range
+    against the 'E' frame and only then writes the image file.
+    write sends the file in 'W' frames and waits for each 'A' frame.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "../../FRAM_CRC32.h"
+#include "../../FRAM_DumpProtocol.h"
+
+#define TIMEOUT_MS 2000
+#define RETRIES 3
+
+struct Frame {
+  uint8_t type;
+  uint32_t addr;
+  std::vector<uint8_t> payload;
+};
+
+class Link {
+  public:
+    Link() : fd(-1) {}
+    ~Link() { if (fd >= 0) close(fd); }
+
+    bool open(const char *device) {
+      fd = ::open(device, O_RDWR | O_NOCTTY);
+      if (fd < 0) {
+        perror(device);
+        return false;
+      }
+      struct termios tio;
+      tcgetattr(fd, &tio);
+      cfmakeraw(&tio);
+      cfsetspeed(&tio, B115200); // ignored by USB CDC, set for real UARTs
+      tcsetattr(fd, TCSANOW, &tio);
+      tcflush(fd, TCIOFLUSH);
+      return true;
+    }
+
+    bool send(uint8_t type, uint32_t addr, const uint8_t *payload, uint16_t len) {
+      uint8_t frame[FRAM_DUMP_MAX_FRAME];
+      uint8_t encoded[FRAM_DUMP_MAX_COBS + 1];
+      uint16_t body = FRAM_DUMP_HEADER_SIZE + len;
+
+      frame[0] = type;
+      FRAM_DumpProtocol::put32(frame + 1, addr);
+      if (len > 0) memcpy(frame + FRAM_DUMP_HEADER_SIZE, payload, len);
+      FRAM_DumpProtocol::put32(frame + body, FRAM_CRC32::compute(frame, body));
+
+      // leading 0x00 flushes whatever partial frame the device may hold
+      encoded[0] = 0x00;
+      uint16_t n = FRAM_DumpProtocol::encode(frame, body + FRAM_DUMP_CRC_SIZE, encoded + 1) + 1;
+      return write(fd, encoded, n) == n;
+    }
+
+    // Waits for the next valid frame, false on timeout
+    bool receive(Frame *frame) {
+      while (true) {
+        while (pos < length) {
+          uint8_t c = buffer[pos++];
+          if (c != 0x00) {
+            if (raw.size() < FRAM_DUMP_MAX_COBS) raw.push_back(c);
+            continue;
+          }
+          bool ok = decodeFrame(frame);
+          raw.clear();
+          if (ok) return true;
+        }
+
+        struct pollfd p = { fd, POLLIN, 0 };
+        if (poll(&p, 1, TIMEOUT_MS) <= 0) return false;
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0) return false;
+        length = n;
+        pos = 0;
+      }
+    }
+
+  private:
+    int fd;
+    uint8_t buffer[4096];
+    ssize_t length = 0;
+    ssize_t pos = 0;
+    std::vector<uint8_t> raw;
+
+    bool decodeFrame(Frame *frame) {
+      uint8_t decoded[FRAM_DUMP_MAX_COBS];
+      if (raw.empty()) return false;
+      uint16_t n = FRAM_DumpProtocol::decode(raw.data(), raw.size(), decoded);
+      if (n < FRAM_DUMP_HEADER_SIZE + FRAM_DUMP_CRC_SIZE) return false;
+
+      uint16_t body = n - FRAM_DUMP_CRC_SIZE;
+      if (FRAM_CRC32::compute(decoded, body) != FRAM_DumpProtocol::get32(decoded + body)) return false;
+
+      frame->type = decoded[0];
+      frame->addr = FRAM_DumpProtocol::get32(decoded + 1);
+      frame->payload.assign(decoded + FRAM_DUMP_HEADER_SIZE, decoded + body);
+      return true;
+    }
+};
+
+static bool queryCapacity(Link &link, uint32_t *capacity) {
+  Frame frame;
+  for (int attempt = 0; attempt < RETRIES; attempt++) {
+    link.send(FRAM_DUMP_CMD_INFO, 0, NULL, 0);
+    while (link.receive(&frame)) {
+      if (frame.type == FRAM_DUMP_CMD_INFO) {
+        *capacity = frame.addr;
+        return true;
+      }
+    }
+  }
+  fprintf(stderr, "no answer from device\n");
+  return false;
+}
+
+// Requests [addr, addr + len) and stores the chunks that arrive intact
+static bool readRange(Link &link, uint32_t addr, uint32_t len, std::vector<uint8_t> &image,
+                      uint32_t base, std::vector<bool> &received, uint32_t *rangeCrc) {
+  uint8_t request[4];
+  FRAM_DumpProtocol::put32(request, len);
+  if (!link.send(FRAM_DUMP_CMD_READ, addr, request, 4)) return false;
+
+  Frame frame;
+  while (link.receive(&frame)) {
+    if ((frame.type == FRAM_DUMP_DATA) && (frame.addr >= base) &&
+        (frame.addr - base + frame.payload.size() <= image.size())) {
+      uint32_t offset = frame.addr - base;
+      memcpy(&image[offset], frame.payload.data(), frame.payload.size());
+      received[offset / FRAM_DUMP_CHUNK] = true;
+    }
+    else if ((frame.type == FRAM_DUMP_END) && (frame.addr == addr) && (frame.payload.size() >= 9)) {
+      if (frame.payload[8] != 0) {
+        fprintf(stderr, "device reported FRAM error %d at 0x%X\n", frame.payload[8], addr);
+        return false;
+      }
+      *rangeCrc = FRAM_DumpProtocol::get32(&frame.payload[4]);
+      return true;
+    }
+  }
+  return false;
+}
+
+static int commandRead(Link &link, const char *path, uint32_t addr, uint32_t len) {
+  std::vector<uint8_t> image(len);
+  std::vector<bool> received((len + FRAM_DUMP_CHUNK - 1) / FRAM_DUMP_CHUNK, false);
+  uint32_t expectedCrc = 0;
+
+  bool haveCrc = readRange(link, addr, len, image, addr, received, &expectedCrc);
+
+  for (int attempt = 0; attempt < RETRIES; attempt++) {
+    bool complete = true;
+    for (size_t i = 0; i < received.size(); i++) {
+      if (received[i]) continue;
+      complete = false;
+      uint32_t offset = i * FRAM_DUMP_CHUNK;
+      uint32_t chunk = (len - offset < FRAM_DUMP_CHUNK) ? len - offset : FRAM_DUMP_CHUNK;
+      uint32_t unused;
+      readRange(link, addr + offset, chunk, image, addr, received, &unused);
+    }
+    if (complete) break;
+  }
+
+  for (size_t i = 0; i < received.size(); i++) {
+    if (!received[i]) {
+      fprintf(stderr, "chunk at 0x%zX missing after %d retries\n", addr + i * FRAM_DUMP_CHUNK, RETRIES);
+      return 1;
+    }
+  }
+  if (!haveCrc) {
+    fprintf(stderr, "no end frame received, range CRC not verified\n");
+    return 1;
+  }
+  if (FRAM_CRC32::compute(image.data(), len) != expectedCrc) {
+    fprintf(stderr, "image CRC mismatch\n");
+    return 1;
+  }
+
+  FILE *f = fopen(path, "wb");
+  if ((f == NULL) || (fwrite(image.data(), 1, len, f) != len)) {
+    perror(path);
+    if (f) fclose(f);
+    return 1;
+  }
+  fclose(f);
+  printf("read %u bytes from 0x%X, CRC-32 0x%08X\n", len, addr, expectedCrc);
+  return 0;
+}
+
+static int commandWrite(Link &link, const char *path, uint32_t addr, uint32_t capacity) {
+  FILE *f = fopen(path, "rb");
+  if (f == NULL) {
+    perror(path);
+    return 1;
+  }
+  std::vector<uint8_t> image;
+  uint8_t block[4096];
+  size_t n;
+  while ((n = fread(block, 1, sizeof(block), f)) > 0) image.insert(image.end(), block, block + n);
+  fclose(f);
+
+  if (addr + image.size() > capacity) {
+    fprintf(stderr, "image does not fit: %zu bytes at 0x%X, capacity %u\n", image.size(), addr, capacity);
+    return 1;
+  }
+
+  for (size_t offset = 0; offset < image.size(); offset += FRAM_DUMP_CHUNK) {
+    uint16_t chunk = (image.size() - offset < FRAM_DUMP_CHUNK) ? image.size() - offset : FRAM_DUMP_CHUNK;
+    uint32_t chunkAddr = addr + offset;
+    bool acked = false;
+
+    for (int attempt = 0; (attempt < RETRIES) && !acked; attempt++) {
+      link.send(FRAM_DUMP_CMD_WRITE, chunkAddr, &image[offset], chunk);
+      Frame frame;
+      while (link.receive(&frame)) {
+        if ((frame.type == FRAM_DUMP_ACK) && (frame.addr == chunkAddr) && !frame.payload.empty()) {
+          if (frame.payload[0] != 0) {
+            fprintf(stderr, "device reported FRAM error %d at 0x%X\n", frame.payload[0], chunkAddr);
+            return 1;
+          }
+          acked = true;
+          break;
+        }
+      }
+    }
+    if (!acked) {
+      fprintf(stderr, "no acknowledge for 0x%X\n", chunkAddr);
+      return 1;
+    }
+  }
+  printf("wrote %zu bytes at 0x%X\n", image.size(), addr);
+  return 0;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: fram_dump info  <device>\n"
+          "       fram_dump read  <device> <image> [address length]\n"
+          "       fram_dump write <device> <image> [address]\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    usage();
+    return 2;
+  }
+  std::string command = argv[1];
+
+  Link link;
+  if (!link.open(argv[2])) return 1;
+
+  uint32_t capacity;
+  if (!queryCapacity(link, &capacity)) return 1;
+
+  if (command == "info") {
+    printf("capacity %u bytes\n", capacity);
+    return 0;
+  }
+  if ((command == "read") && (argc >= 4)) {
+    uint32_t addr = (argc >= 6) ? strtoul(argv[4], NULL, 0) : 0;
+    uint32_t len = (argc >= 6) ? strtoul(argv[5], NULL, 0) : capacity;
+    if ((len == 0) || (addr + len > capacity)) {
+      fprintf(stderr, "range outside capacity %u\n", capacity);
+      return 1;
+    }
+    return commandRead(link, argv[3], addr, len);
+  }
+  if ((command == "write") && (argc >= 4)) {
+    uint32_t addr = (argc >= 5) ? strtoul(argv[4], NULL, 0) : 0;
+    return commandWrite(link, argv[3], addr, capacity);
+  }
+
+  usage();
+  return 2;
+}
@@ -0,0 +1,132 @@
+/*
+
+  I2CArbiter: priorities on a shared bus, see I2CArbiter.h
+
+*/
+
+#include "I2CArbiter.h"
+
+#define SLICE_OVERHEAD 3 // device address + 16-bit memory address
+
+I2CArbiter::I2CArbiter(I2CBus *bus, uint16_t sliceBytes) {
+  this->bus = bus;
+  this->sliceBytes = (sliceBytes > 0) ? sliceBytes : 1;
+  running = I2C_ARBITER_LEVELS;
+  for (uint8_t level = 0; level < I2C_ARBITER_LEVELS; level++) {
+    head[level] = 0;
+    tail[level] = 0;
+    jobBytes[level] = SLICE_OVERHEAD + this->sliceBytes;
+  }
+  resetStats();
+}
+
+void I2CArbiter::setJobBytes(uint8_t priority, uint16_t bytes) {
+  if (priority < I2C_ARBITER_LEVELS) jobBytes[priority] = bytes;
+}
+
+// One slice or one job of any lower level can be on the bus when a job is posted
+uint32_t I2CArbiter::getBlockingBound(uint8_t priority) {
+  if (bus->getDeadline() == 0) return I2CBus::UNBOUNDED;
+
+  uint32_t bound = 0;
+  for (uint8_t level = priority + 1; level < I2C_ARBITER_LEVELS; level++) {
+    uint32_t slice = bus->getWorstCaseUs(SLICE_OVERHEAD + sliceBytes);
+    uint32_t job = (jobBytes[level] > 0) ? bus->getWorstCaseUs(jobBytes[level]) : 0;
+    if (slice > bound) bound = slice;
+    if (job > bound) bound = job;
+  }
+  return bound;
+}
+
+void I2CArbiter::resetStats() {
+  memset(stats, 0, sizeof(stats));
+}
+
+bool I2CArbiter::request(uint8_t priority, Job job, void *context) {
+  if (priority >= I2C_ARBITER_LEVELS) return false;
+
+  bool queued = false;
+  noInterrupts();
+  uint8_t next = (tail[priority] + 1) % I2C_ARBITER_QUEUE;
+  if (next != head[priority]) {
+    Entry &entry = queue[priority][tail[priority]];
+    entry.job = job;
+    entry.context = context;
+    entry.posted = micros();
+    tail[priority] = next;
+    queued = true;
+  } else {
+    stats[priority].dropped++;
+  }
+  interrupts();
+  return queued;
+}
+
+void I2CArbiter::service(uint8_t below) {
+  if (below > running) below = running; // inside a job or slice only higher levels may run
+
+  uint8_t level = 0;
+  while (level < below) {
+    if (head[level] == tail[level]) {
+      level++;
+      continue;
+    }
+
+    Entry entry = queue[level][head[level]];
+    head[level] = (head[level] + 1) % I2C_ARBITER_QUEUE;
+
+    uint32_t latency = micros() - entry.posted;
+    LevelStats &s = stats[level];
+    s.jobs++;
+    s.totalLatencyUs += latency;
+    if (latency > s.maxLatencyUs) s.maxLatencyUs = latency;
+
+    uint8_t previous = running;
+    running = level;
+    entry.job(entry.context);
+    running = previous;
+
+    level = 0; // a job may have posted something more urgent
+  }
+}
+
+uint8_t I2CArbiter::writeMemory(uint8_t priority, uint8_t address, uint16_t memAddr, const uint8_t *data, size_t len) {
+  return transfer(priority, address, memAddr, data, NULL, len);
+}
+
+uint8_t I2CArbiter::readMemory(uint8_t priority, uint8_t address, uint16_t memAddr, uint8_t *data, size_t len) {
+  return transfer(priority, address, memAddr, NULL, data, len);
+}
+
+uint8_t I2CArbiter::transfer(uint8_t priority, uint8_t address, uint16_t memAddr, const uint8_t *tx, uint8_t *rx, size_t len) {
+  if (priority >= I2C_ARBITER_LEVELS) priority = I2C_ARBITER_LEVELS - 1;
+  uint8_t result = I2CBus::OK;
+  size_t done = 0;
+
+  while ((done < len) && (result == I2CBus::OK)) {
+    service(priority); // the yield point: anything more urgent goes first
+
+    size_t slice = len - done;
+    if (slice > sliceBytes) slice = sliceBytes;
+    uint16_t sliceAddr = memAddr + done;
+    uint8_t reg[2] = { (uint8_t)(sliceAddr >> 8), (uint8_t)(sliceAddr & 0xFF) };
+
+    uint8_t previous = running;
+    running = priority;
+    uint32_t start = micros();
+    if (tx != NULL) {
+      result = bus->writeRegister(address, reg, 2, tx + done, slice);
+    } else {
+      result = bus->readRegister(address, reg, 2, rx + done, slice);
+    }
+    uint32_t elapsed = micros() - start;
+    running = previous;
+
+    LevelStats &s = stats[priority];
+    s.slices++;
+    if (elapsed > s.maxSliceUs) s.maxSliceUs = elapsed;
+
+    done += slice;
+  }
+  return result;
+}
@@ -0,0 +1,105 @@
+/*
+
+  I2CArbiter: priorities on a shared bus
+
+  The FRAM shares Wire2 with a pressure sensor. A 128-byte FRAM write at
+  400 kHz keeps the bus ~3 ms, during which the next sensor read has to
+  wait. The arbiter cuts bulk memory transfers into slices of sliceBytes
+  and runs queued jobs of a higher priority between two slices.
+
+  Priority 0 is the highest. Jobs are functions posted with request(),
+  also from an interrupt (e.g. the DLC end-of-conversion pin). They run
+  from service(), from loop() or between the slices of a transfer.
+
+  Guaranteed blocking: lower levels delay a job by at most the one slice or
+  job of theirs that is running when it is posted (plus the jobs queued
+  before it at the same or a higher level). getBlockingBound(level) is the
+  longest of those, from I2CBus::getWorstCaseUs(): clock, slice size,
+  retries, backoff, recovery and deadline. Jobs are taken as one
+  transaction of setJobBytes() bytes (default: a slice). Without an I2CBus
+  deadline it is I2CBus::UNBOUNDED. The measured slice times and queue
+  latencies are kept per level.
+
+  All traffic on the bus must go through the arbiter (jobs or sliced
+  transfers) for the bound to hold: it schedules, it cannot interrupt a
+  TwoWire call.
+
+    I2CArbiter arbiter(&bus2, 16);
+    void readSensor(void *context) { ((AllSensors_DLC *) context)->readData(); }
+    void eocA() { arbiter.request(0, readSensor, &sensorA); }     // attachInterrupt(EOC_A, eocA, RISING)
+    ...
+    arbiter.writeMemory(2, 0x50, logAddr, block, sizeof(block)); // sliced, sensor reads slip in between
+    arbiter.service();                                            // in loop()
+
+*/
+
+#ifndef I2CARBITER_H
+#define I2CARBITER_H
+
+#include <Arduino.h>
+#include "I2CBus.h"
+
+#define I2C_ARBITER_LEVELS 3
+#define I2C_ARBITER_QUEUE 4 // jobs per level
+
+class I2CArbiter {
+public:
+
+  typedef void (*Job)(void *context);
+
+  struct LevelStats {
+    uint32_t jobs;
+    uint32_t dropped;        // request() on a full queue
+    uint32_t maxLatencyUs;   // request() to start of the job
+    uint32_t totalLatencyUs;
+    uint32_t slices;         // slices of transfers at this level
+    uint32_t maxSliceUs;
+  };
+
+  I2CArbiter(I2CBus *bus, uint16_t sliceBytes = 16);
+
+  // Queues a job, interrupt safe. False if the queue of the level is full.
+  bool request(uint8_t priority, Job job, void *context);
+
+  // Runs queued jobs with a priority above (a lower number than) 'below', highest first
+  void service(uint8_t below = I2C_ARBITER_LEVELS);
+
+  // Sliced transfers to devices with a 16-bit memory address (FRAM >= 64K, EEPROM)
+  uint8_t writeMemory(uint8_t priority, uint8_t address, uint16_t memAddr, const uint8_t *data, size_t len);
+  uint8_t readMemory(uint8_t priority, uint8_t address, uint16_t memAddr, uint8_t *data, size_t len);
+
+  // Largest transaction of a job at this level, address and register bytes included, 0: no bus traffic
+  void setJobBytes(uint8_t priority, uint16_t bytes);
+
+  // Longest delay lower levels can add to a job at this level, I2CBus::UNBOUNDED without a deadline
+  uint32_t getBlockingBound(uint8_t priority);
+
+  const LevelStats &getStats(uint8_t priority) {
+    return stats[priority];
+  }
+
+  void resetStats();
+
+private:
+
+  struct Entry {
+    Job job;
+    void *context;
+    uint32_t posted;
+  };
+
+  I2CBus *bus;
+  uint16_t sliceBytes;
+  uint16_t jobBytes[I2C_ARBITER_LEVELS];
+
+  Entry queue[I2C_ARBITER_LEVELS][I2C_ARBITER_QUEUE];
+  volatile uint8_t head[I2C_ARBITER_LEVELS];
+  volatile uint8_t tail[I2C_ARBITER_LEVELS];
+  uint8_t running; // level of the job or transfer in progress, I2C_ARBITER_LEVELS when idle
+
+  LevelStats stats[I2C_ARBITER_LEVELS];
+
+  uint8_t transfer(uint8_t priority, uint8_t address, uint16_t memAddr, const uint8_t *tx, uint8_t *rx, size_t len);
+};
+
+#endif // I2CARBITER_H
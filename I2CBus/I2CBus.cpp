@@ -0,0 +1,216 @@
+/*
+
+  I2CBus: transaction layer on top of TwoWire, see I2CBus.h
+
+*/
+
+#include "I2CBus.h"
+#include "I2CProfiler.h"
+
+#if defined(ARDUINO_ARCH_SAMD)
+#include "wiring_private.h" // pinPeripheral() function
+#endif
+
+#define RECOVERY_PULSES 9      // a slave stuck in a read releases SDA within 9 clocks
+#define RECOVERY_HALF_PERIOD 5 // us, 100 kHz
+#define RECOVERY_RESTART_US 50 // allowance for TwoWire end() / begin() and the pin muxing
+#define ATTEMPT_OVERHEAD_US 50 // allowance for the TwoWire calls around the bus time
+
+I2CBus::I2CBus(TwoWire *wire, uint8_t sdaPin, uint8_t sclPin, uint8_t pinMux) {
+  this->wire = wire;
+  this->sdaPin = sdaPin;
+  this->sclPin = sclPin;
+  this->pinMux = pinMux;
+  this->clock = 100000;
+
+  deadlineUs = DEFAULT_DEADLINE_US;
+  retries = DEFAULT_RETRIES;
+  backoffUs = DEFAULT_BACKOFF_US;
+  profiler = NULL;
+
+  resetCounters();
+}
+
+void I2CBus::begin(uint32_t clock) {
+  this->clock = clock;
+  wire->begin();
+  wire->setClock(clock);
+  attachPins();
+}
+
+void I2CBus::setClock(uint32_t clock) {
+  this->clock = clock;
+  wire->setClock(clock);
+}
+
+void I2CBus::resetCounters() {
+  memset(&counters, 0, sizeof(counters));
+}
+
+uint32_t I2CBus::getWorstCaseUs(size_t bytes) {
+  if ((deadlineUs == 0) || (clock == 0)) return UNBOUNDED;
+
+  // 9 bits per byte, the address once more after a repeated start, start / stop conditions
+  uint32_t bits = (uint32_t)(bytes + 1) * 9 + 4;
+  uint32_t attemptUs = (uint32_t)(((uint64_t) bits * 1000000UL + clock - 1) / clock) + ATTEMPT_OVERHEAD_US;
+  uint32_t recoveryUs = (2 * RECOVERY_PULSES + 3) * RECOVERY_HALF_PERIOD + RECOVERY_RESTART_US;
+  uint32_t oneUs = attemptUs + recoveryUs;
+
+  uint64_t allUs = (uint64_t)(retries + 1) * oneUs + (uint64_t) backoffUs * ((1UL << retries) - 1);
+  uint64_t deadlineBoundUs = (uint64_t) deadlineUs + oneUs; // the deadline is only checked before a retry
+  uint64_t bound = (allUs < deadlineBoundUs) ? allUs : deadlineBoundUs;
+  return (bound < UNBOUNDED) ? (uint32_t) bound : UNBOUNDED;
+}
+
+uint8_t I2CBus::probe(uint8_t address) {
+  return transfer(address, NULL, 0, NULL, 0, NULL, 0, retries);
+}
+
+uint8_t I2CBus::probeOnce(uint8_t address) {
+  return transfer(address, NULL, 0, NULL, 0, NULL, 0, 0);
+}
+
+uint8_t I2CBus::write(uint8_t address, const uint8_t *data, size_t len) {
+  return transfer(address, NULL, 0, data, len, NULL, 0, retries);
+}
+
+uint8_t I2CBus::read(uint8_t address, uint8_t *data, size_t len) {
+  return transfer(address, NULL, 0, NULL, 0, data, len, retries);
+}
+
+uint8_t I2CBus::writeRegister(uint8_t address, const uint8_t *reg, size_t regLen, const uint8_t *data, size_t len) {
+  return transfer(address, reg, regLen, data, len, NULL, 0, retries);
+}
+
+uint8_t I2CBus::readOnce(uint8_t address, uint8_t *data, size_t len) {
+  return transfer(address, NULL, 0, NULL, 0, data, len, 0);
+}
+
+uint8_t I2CBus::readRegister(uint8_t address, const uint8_t *reg, size_t regLen, uint8_t *data, size_t len) {
+  return transfer(address, reg, regLen, NULL, 0, data, len, retries);
+}
+
+uint8_t I2CBus::writeCommand(uint8_t address, const uint8_t *data, size_t len, uint8_t command) {
+  return transfer(address, NULL, 0, data, len, NULL, 0, retries, command);
+}
+
+// Both lines high: nobody is holding the bus
+bool I2CBus::linesIdle() {
+  return (digitalRead(sdaPin) == HIGH) && (digitalRead(sclPin) == HIGH);
+}
+
+// Clocks a stuck slave out of its transfer, sends STOP and restarts the SERCOM
+bool I2CBus::recover() {
+  counters.recoveries++;
+
+  wire->end();
+  pinMode(sdaPin, INPUT_PULLUP);
+  pinMode(sclPin, INPUT_PULLUP);
+  delayMicroseconds(RECOVERY_HALF_PERIOD);
+
+  for (uint8_t i = 0; (i < RECOVERY_PULSES) && (digitalRead(sdaPin) == LOW); i++) {
+    digitalWrite(sclPin, LOW);
+    pinMode(sclPin, OUTPUT);
+    delayMicroseconds(RECOVERY_HALF_PERIOD);
+    pinMode(sclPin, INPUT_PULLUP);
+    delayMicroseconds(RECOVERY_HALF_PERIOD);
+  }
+
+  // STOP: SDA rises while SCL is high
+  digitalWrite(sdaPin, LOW);
+  pinMode(sdaPin, OUTPUT);
+  delayMicroseconds(RECOVERY_HALF_PERIOD);
+  pinMode(sdaPin, INPUT_PULLUP);
+  delayMicroseconds(RECOVERY_HALF_PERIOD);
+
+  bool released = linesIdle();
+
+  wire->begin();
+  wire->setClock(clock);
+  attachPins();
+  return released;
+}
+
+// Mux the pins back to the SERCOM, keeping the input buffers on for linesIdle()
+void I2CBus::attachPins() {
+#if defined(ARDUINO_ARCH_SAMD)
+  pinPeripheral(sdaPin, (EPioType) pinMux);
+  pinPeripheral(sclPin, (EPioType) pinMux);
+  PORT->Group[g_APinDescription[sdaPin].ulPort].PINCFG[g_APinDescription[sdaPin].ulPin].bit.INEN = 1;
+  PORT->Group[g_APinDescription[sclPin].ulPort].PINCFG[g_APinDescription[sclPin].ulPin].bit.INEN = 1;
+#endif
+}
+
+uint8_t I2CBus::transfer(uint8_t address, const uint8_t *reg, size_t regLen,
+                         const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen, uint8_t maxRetries,
+                         uint8_t command) {
+  counters.transactions++;
+  uint32_t start = micros();
+  uint8_t result = OK;
+
+  for (uint8_t n = 0; n <= maxRetries; n++) {
+    if (n > 0) {
+      uint32_t wait = (uint32_t) backoffUs << (n - 1);
+      if ((deadlineUs > 0) && ((uint32_t)(micros() - start) + wait > deadlineUs)) {
+        counters.timeouts++;
+        result = TIMEOUT;
+        break;
+      }
+      counters.retries++;
+      delayMicroseconds(wait);
+    }
+
+    if (!linesIdle()) {
+      counters.stuckBus++;
+      if (!recover()) {
+        result = BUS_STUCK;
+        continue;
+      }
+    }
+
+    result = attempt(address, reg, regLen, tx, txLen, rx, rxLen, command);
+    if ((result == OK) || (result == DATA_TOO_LONG)) break; // retrying won't make it fit
+  }
+
+  if (result != OK) counters.failures++;
+  if (profiler != NULL) profiler->record(address, regLen + txLen + rxLen, micros() - start, result);
+  return result;
+}
+
+uint8_t I2CBus::attempt(uint8_t address, const uint8_t *reg, size_t regLen,
+                        const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen, uint8_t command) {
+  uint8_t result = OK;
+
+  if ((regLen > 0) || (txLen > 0) || (rxLen == 0)) {
+    wire->beginTransmission(address);
+    if ((wire->write(reg, regLen) != regLen) || (wire->write(tx, txLen) != txLen)) {
+      wire->endTransmission();
+      return DATA_TOO_LONG;
+    }
+    result = wire->endTransmission((rxLen == 0) && (command == NO_COMMAND)); // repeated start before a read or command
+    if ((result == NACK_ADDRESS) || (result == NACK_DATA)) counters.nacks++;
+  }
+
+  if ((result == OK) && (command != NO_COMMAND)) {
+    wire->beginTransmission(command);
+    result = wire->endTransmission();
+    if (result == NACK_ADDRESS) counters.nacks++;
+  }
+
+  if ((result == OK) && (rxLen > 0)) {
+    size_t received = wire->requestFrom(address, rxLen, true);
+    for (size_t i = 0; i < received; i++) {
+      uint8_t c = wire->read();
+      if (i < rxLen) rx[i] = c;
+    }
+    if (received == 0) {
+      // requestFrom() returns nothing when the read header is not acknowledged
+      counters.nacks++;
+      result = NACK_ADDRESS;
+    } else if (received < rxLen) {
+      counters.shortReads++;
+      result = SHORT_READ;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,158 @@
+/*
+
+  I2CBus: transaction layer on top of TwoWire
+
+  Every transaction gets
+    * a deadline covering all attempts (and the backoff between them),
+    * short-read detection (requestFrom() returning fewer bytes),
+    * retries with exponential backoff,
+    * bus recovery when SDA or SCL is held low: up to 9 SCL pulses, a STOP,
+      then the SERCOM is restarted and the pins are muxed back.
+
+  The line check runs before TwoWire is called, so a device holding SDA low
+  costs one recovery attempt instead of a TwoWire call that never returns
+  (the SAMD core waits for the bus without a timeout). A TwoWire call that
+  is already running cannot be aborted.
+
+  Results are the endTransmission() codes 0..4, extended with
+  SHORT_READ, TIMEOUT and BUS_STUCK. A read that returns no bytes at all
+  is NACK_ADDRESS (the read header was not acknowledged).
+
+  Usage (Wire2 on the DevBoard):
+
+    TwoWire Wire2(&sercom1, W2_SDA, W2_SCL);
+    I2CBus bus2(&Wire2, W2_SDA, W2_SCL, PIO_SERCOM);
+
+    bus2.begin(400000);  // replaces Wire2.begin() + pinPeripheral()
+    fram.setI2CBus(&bus2);
+
+*/
+
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+class I2CProfiler;
+
+class I2CBus {
+public:
+
+  enum Result {
+    OK            = 0,
+    DATA_TOO_LONG = 1,
+    NACK_ADDRESS  = 2,
+    NACK_DATA     = 3,
+    OTHER_ERROR   = 4,
+    SHORT_READ    = 5,
+    TIMEOUT       = 6,
+    BUS_STUCK     = 7
+  };
+
+  // Event counters, since begin() or resetCounters()
+  struct Counters {
+    uint32_t transactions;
+    uint32_t failures;     // transactions that did not end in OK
+    uint32_t retries;
+    uint32_t nacks;
+    uint32_t shortReads;
+    uint32_t timeouts;
+    uint32_t stuckBus;     // line check found SDA or SCL low
+    uint32_t recoveries;   // recovery attempts
+  };
+
+  static const uint32_t DEFAULT_DEADLINE_US = 5000;
+  static const uint8_t DEFAULT_RETRIES = 2;
+  static const uint16_t DEFAULT_BACKOFF_US = 100;
+  static const uint32_t UNBOUNDED = 0xFFFFFFFFUL;
+  static const uint8_t NO_COMMAND = 0xFF;
+
+  // pinMux is the pinPeripheral() setting of both pins (SAMD), ignored elsewhere
+  I2CBus(TwoWire *wire, uint8_t sdaPin, uint8_t sclPin, uint8_t pinMux);
+
+  void begin(uint32_t clock = 100000);
+  void setClock(uint32_t clock);
+
+  uint32_t getClock() {
+    return clock;
+  }
+
+  // Deadline for one transaction including retries, 0 = no deadline
+  void setDeadline(uint32_t deadlineUs) {
+    this->deadlineUs = deadlineUs;
+  }
+
+  uint32_t getDeadline() {
+    return deadlineUs;
+  }
+
+  // Retry n times, waiting backoffUs, 2 x backoffUs, 4 x backoffUs, ... in between
+  void setRetries(uint8_t retries, uint16_t backoffUs) {
+    this->retries = retries;
+    this->backoffUs = backoffUs;
+  }
+
+  // Upper bound of one transaction moving bytes (address and register bytes
+  // included): every attempt and recovery, the backoff, and the one attempt
+  // that may still start just before the deadline. UNBOUNDED without a
+  // deadline. Assumes no device stretches SCL beyond what recovery clears.
+  uint32_t getWorstCaseUs(size_t bytes);
+
+  uint8_t probe(uint8_t address);
+  // One attempt, no retries: wake-up calls that the device does not acknowledge
+  uint8_t probeOnce(uint8_t address);
+  uint8_t write(uint8_t address, const uint8_t *data, size_t len);
+  uint8_t read(uint8_t address, uint8_t *data, size_t len);
+  // One attempt, no retries: for devices that NACK their address while busy
+  uint8_t readOnce(uint8_t address, uint8_t *data, size_t len);
+
+  // Register / memory address bytes followed by data, in one transaction
+  uint8_t writeRegister(uint8_t address, const uint8_t *reg, size_t regLen, const uint8_t *data, size_t len);
+  // Register / memory address bytes, repeated start, then read
+  uint8_t readRegister(uint8_t address, const uint8_t *reg, size_t regLen, uint8_t *data, size_t len);
+  // Data, repeated start, then the command address alone (e.g. FRAM sleep: 0xF8, device, 0x86)
+  uint8_t writeCommand(uint8_t address, const uint8_t *data, size_t len, uint8_t command);
+
+  // Records every transaction in the profiler, NULL to stop
+  void setProfiler(I2CProfiler *profiler) {
+    this->profiler = profiler;
+  }
+
+  bool linesIdle();
+  bool recover();
+
+  TwoWire *getWire() {
+    return wire;
+  }
+
+  const Counters &getCounters() {
+    return counters;
+  }
+
+  void resetCounters();
+
+private:
+
+  TwoWire *wire;
+  uint8_t sdaPin;
+  uint8_t sclPin;
+  uint8_t pinMux;
+  uint32_t clock;
+
+  uint32_t deadlineUs;
+  uint8_t retries;
+  uint16_t backoffUs;
+
+  Counters counters;
+  I2CProfiler *profiler;
+
+  uint8_t transfer(uint8_t address, const uint8_t *reg, size_t regLen,
+                   const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen, uint8_t maxRetries,
+                   uint8_t command = NO_COMMAND);
+  uint8_t attempt(uint8_t address, const uint8_t *reg, size_t regLen,
+                  const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen, uint8_t command);
+  void attachPins();
+};
+
+#endif // I2CBUS_H
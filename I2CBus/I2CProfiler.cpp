@@ -0,0 +1,155 @@
+/*
+
+  I2CProfiler: per-device bus time and error statistics, see I2CProfiler.h
+
+*/
+
+#include "I2CProfiler.h"
+#include "I2CBus.h"
+
+#define PROFILER_MAGIC   0x5049 // "IP"
+#define PROFILER_VERSION 2 // 2: 32-bit histogram bins
+
+I2CProfiler::I2CProfiler() {
+  reset();
+}
+
+void I2CProfiler::reset() {
+  memset(devices, 0, sizeof(devices));
+  count = 0;
+  unrecorded = 0;
+}
+
+int8_t I2CProfiler::find(uint8_t address) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (devices[i].address == address) return i;
+  }
+  return -1;
+}
+
+void I2CProfiler::record(uint8_t address, uint16_t bytes, uint32_t elapsedUs, uint8_t result) {
+  int8_t index = find(address);
+  if (index < 0) {
+    if (count >= I2C_PROFILER_DEVICES) {
+      unrecorded++;
+      return;
+    }
+    index = count++;
+    devices[index].address = address;
+    devices[index].minUs = 0xFFFFFFFF;
+  }
+
+  Device &d = devices[index];
+  d.transactions++;
+  d.bytes += bytes;
+  d.totalUs += elapsedUs;
+  if (elapsedUs < d.minUs) d.minUs = elapsedUs;
+  if (elapsedUs > d.maxUs) d.maxUs = elapsedUs;
+
+  uint8_t n = bucket(elapsedUs);
+  d.histogram[n]++;
+
+  if ((result == I2CBus::NACK_ADDRESS) || (result == I2CBus::NACK_DATA)) d.nacks++;
+  if (result == I2CBus::SHORT_READ) d.shortReads++;
+  if (result != I2CBus::OK) d.failures++;
+}
+
+uint32_t I2CProfiler::meanMicros(uint8_t index) {
+  const Device &d = devices[index];
+  return (d.transactions > 0) ? d.totalUs / d.transactions : 0;
+}
+
+uint32_t I2CProfiler::percentileMicros(uint8_t index, uint8_t percentile) {
+  const Device &d = devices[index];
+  uint32_t total = 0;
+  for (uint8_t n = 0; n < I2C_PROFILER_BUCKETS; n++) {
+    total += d.histogram[n];
+  }
+  if (total == 0) return 0;
+
+  uint32_t target = (uint32_t)(((uint64_t) total * percentile + 99) / 100); // rank, rounded up
+  uint32_t seen = 0;
+  for (uint8_t n = 0; n < I2C_PROFILER_BUCKETS - 1; n++) {
+    seen += d.histogram[n];
+    if (seen >= target) return min((uint32_t) 1 << n, d.maxUs);
+  }
+  return d.maxUs;
+}
+
+// log2 bucket: 0 for 0 us, n for [2^(n-1), 2^n)
+uint8_t I2CProfiler::bucket(uint32_t us) {
+  uint8_t n = 0;
+  while ((us > 0) && (n < I2C_PROFILER_BUCKETS - 1)) {
+    us >>= 1;
+    n++;
+  }
+  return n;
+}
+
+void I2CProfiler::printCSV(Print &out) {
+  out.println("address,transactions,bytes,min_us,mean_us,max_us,p99_us,nacks,short_reads,failures");
+  for (uint8_t i = 0; i < count; i++) {
+    const Device &d = devices[i];
+    out.print("0x");
+    if (d.address < 16) out.print("0");
+    out.print(d.address, HEX);
+    out.print(',');
+    out.print(d.transactions);
+    out.print(',');
+    out.print(d.bytes);
+    out.print(',');
+    out.print(d.minUs);
+    out.print(',');
+    out.print(meanMicros(i));
+    out.print(',');
+    out.print(d.maxUs);
+    out.print(',');
+    out.print(percentileMicros(i, 99));
+    out.print(',');
+    out.print(d.nacks);
+    out.print(',');
+    out.print(d.shortReads);
+    out.print(',');
+    out.println(d.failures);
+  }
+}
+
+static void put16(Print &out, uint16_t value) {
+  out.write((uint8_t) value);
+  out.write((uint8_t)(value >> 8));
+}
+
+static void put32(Print &out, uint32_t value) {
+  put16(out, (uint16_t) value);
+  put16(out, (uint16_t)(value >> 16));
+}
+
+/*
+  Binary report, little endian:
+    u16 magic 0x5049, u8 version, u8 device count, u32 unrecorded
+    per device: u8 address, u32 transactions, bytes, totalUs, minUs, maxUs,
+                nacks, shortReads, failures, u32 histogram[I2C_PROFILER_BUCKETS]
+*/
+size_t I2CProfiler::writeBinary(Print &out) {
+  put16(out, PROFILER_MAGIC);
+  out.write((uint8_t) PROFILER_VERSION);
+  out.write(count);
+  put32(out, unrecorded);
+
+  for (uint8_t i = 0; i < count; i++) {
+    const Device &d = devices[i];
+    out.write(d.address);
+    put32(out, d.transactions);
+    put32(out, d.bytes);
+    put32(out, d.totalUs);
+    put32(out, d.minUs);
+    put32(out, d.maxUs);
+    put32(out, d.nacks);
+    put32(out, d.shortReads);
+    put32(out, d.failures);
+    for (uint8_t n = 0; n < I2C_PROFILER_BUCKETS; n++) {
+      put32(out, d.histogram[n]);
+    }
+  }
+  return 8 + (size_t) count * (1 + 8 * 4 + I2C_PROFILER_BUCKETS * 4);
+}
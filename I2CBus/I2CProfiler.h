@@ -0,0 +1,83 @@
+/*
+
+  I2CProfiler: per-device bus time and error statistics
+
+  Attached to an I2CBus (bus.setProfiler(&profiler)) it records every
+  transaction by device address: count, bytes moved, latency (min, mean,
+  max and a log2 histogram for percentiles), NACKs, short reads and
+  failures. Only traffic that goes through the I2CBus is seen: drivers
+  that run through it (setI2CBus()) are covered without changes, plain
+  Wire calls on the same bus are not.
+
+  Export over any Print (Serial, an SD file, ...):
+    printCSV(Serial)    one line per device, header first
+    writeBinary(Serial) compact little-endian records, see writeBinary()
+
+  Histogram bucket n counts latencies in [2^(n-1), 2^n) us (bucket 0:
+  below 1 us), so percentiles are upper bounds within a factor of 2.
+
+*/
+
+#ifndef I2CPROFILER_H
+#define I2CPROFILER_H
+
+#include <Arduino.h>
+
+#define I2C_PROFILER_DEVICES 8
+#define I2C_PROFILER_BUCKETS 16 // up to 32 ms, the last bucket takes everything above
+
+class I2CProfiler {
+public:
+
+  struct Device {
+    uint8_t address;
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t totalUs;
+    uint32_t minUs;
+    uint32_t maxUs;
+    uint32_t nacks;
+    uint32_t shortReads;
+    uint32_t failures;   // any result other than OK, NACKs and short reads included
+    uint32_t histogram[I2C_PROFILER_BUCKETS];
+  };
+
+  I2CProfiler();
+
+  // Called by I2CBus after every transaction (result: I2CBus::Result)
+  void record(uint8_t address, uint16_t bytes, uint32_t elapsedUs, uint8_t result);
+
+  void reset();
+
+  uint8_t deviceCount() {
+    return count;
+  }
+
+  const Device &device(uint8_t index) {
+    return devices[index];
+  }
+
+  // Index of an address, -1 if it has no transactions yet
+  int8_t find(uint8_t address);
+
+  uint32_t meanMicros(uint8_t index);
+  // Upper bound of the given percentile (1..100), from the histogram
+  uint32_t percentileMicros(uint8_t index, uint8_t percentile);
+
+  void printCSV(Print &out);
+  size_t writeBinary(Print &out);
+
+  uint32_t getUnrecorded() {
+    return unrecorded;
+  }
+
+private:
+
+  Device devices[I2C_PROFILER_DEVICES];
+  uint8_t count;
+  uint32_t unrecorded; // transactions to addresses beyond I2C_PROFILER_DEVICES
+
+  static uint8_t bucket(uint32_t us);
+};
+
+#endif // I2CPROFILER_H
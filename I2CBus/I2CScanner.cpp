@@ -0,0 +1,164 @@
+/*
+
+  I2CScanner: presence scan of up to I2C_SCANNER_MAX_BUSES buses at once, see I2CScanner.h
+
+*/
+
+#include "I2CScanner.h"
+
+#define BUSSTATE_IDLE  1
+#define BUSSTATE_OWNER 2
+#define CMD_STOP       3
+
+I2CScanner::I2CScanner() {
+  busCount = 0;
+  handler = NULL;
+  probeTimeoutUs = DEFAULT_PROBE_TIMEOUT_US;
+  lastScanUs = 0;
+  maxScanUs = 0;
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+int8_t I2CScanner::addBus(TwoWire *wire, Sercom *sercom) {
+  int8_t index = addBus(wire);
+  if (index >= 0) buses[index].sercom = sercom;
+  return index;
+}
+#endif
+
+int8_t I2CScanner::addBus(TwoWire *wire) {
+  if (busCount >= I2C_SCANNER_MAX_BUSES) return -1;
+
+  Bus &bus = buses[busCount];
+  bus.wire = wire;
+#if defined(ARDUINO_ARCH_SAMD)
+  bus.sercom = NULL;
+#endif
+  memset(bus.present, 0, sizeof(bus.present));
+  bus.state = PROBE_DONE;
+  bus.timedOut = false;
+  return busCount++;
+}
+
+uint16_t I2CScanner::scan() {
+  uint32_t start = micros();
+
+  for (uint8_t i = 0; i < busCount; i++) {
+    Bus &bus = buses[i];
+    memcpy(bus.found, bus.present, sizeof(bus.found)); // addresses left unprobed keep their state
+    bus.address = FIRST_ADDRESS;
+    bus.state = PROBE_IDLE;
+    bus.probeStart = start;
+    bus.timedOut = false;
+  }
+
+  // Round robin: every pass starts or finishes at most one probe per bus
+  bool running = true;
+  while (running) {
+    running = false;
+    for (uint8_t i = 0; i < busCount; i++) {
+      step(buses[i]);
+      if (buses[i].state != PROBE_DONE) running = true;
+    }
+  }
+
+  lastScanUs = micros() - start;
+  if (lastScanUs > maxScanUs) maxScanUs = lastScanUs;
+
+  uint16_t changes = 0;
+  for (uint8_t i = 0; i < busCount; i++) {
+    changes += report(i);
+  }
+  return changes;
+}
+
+bool I2CScanner::isPresent(uint8_t bus, uint8_t address) {
+  return (buses[bus].present[address >> 3] >> (address & 7)) & 1;
+}
+
+uint8_t I2CScanner::deviceCount(uint8_t bus) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < I2C_SCANNER_BITMAP_SIZE; i++) {
+    for (uint8_t bits = buses[bus].present[i]; bits != 0; bits &= bits - 1) {
+      count++;
+    }
+  }
+  return count;
+}
+
+// Advances the probe of one bus without blocking (SERCOM) or by one probe (TwoWire)
+void I2CScanner::step(Bus &bus) {
+  if (bus.state == PROBE_DONE) return;
+
+  bool finished = false;
+  bool present = false;
+
+#if defined(ARDUINO_ARCH_SAMD)
+  if (bus.sercom != NULL) {
+    SercomI2cm &i2c = bus.sercom->I2CM;
+
+    if (bus.state == PROBE_IDLE) {
+      uint8_t busState = i2c.STATUS.bit.BUSSTATE;
+      if ((busState == BUSSTATE_IDLE) || (busState == BUSSTATE_OWNER)) {
+        i2c.ADDR.bit.ADDR = bus.address << 1; // START + address, write
+        bus.state = PROBE_WAIT;
+      }
+    } else if (i2c.INTFLAG.bit.MB || i2c.INTFLAG.bit.SB) {
+      // MB is also set on bus error and lost arbitration
+      present = !i2c.STATUS.bit.RXNACK && !i2c.STATUS.bit.BUSERR && !i2c.STATUS.bit.ARBLOST;
+      i2c.CTRLB.bit.CMD = CMD_STOP;
+      while (i2c.SYNCBUSY.bit.SYSOP);
+      finished = true;
+    }
+
+    if (!finished && ((uint32_t)(micros() - bus.probeStart) > probeTimeoutUs)) {
+      if (bus.state == PROBE_WAIT) {
+        i2c.CTRLB.bit.CMD = CMD_STOP;
+        while (i2c.SYNCBUSY.bit.SYSOP);
+      }
+      bus.timedOut = true;
+      bus.state = PROBE_DONE;
+      return;
+    }
+  } else
+#endif
+  {
+    bus.wire->beginTransmission(bus.address);
+    present = (bus.wire->endTransmission() == 0);
+    finished = true;
+  }
+
+  if (!finished) return;
+
+  if (present) {
+    bus.found[bus.address >> 3] |= (1 << (bus.address & 7));
+  } else {
+    bus.found[bus.address >> 3] &= ~(1 << (bus.address & 7));
+  }
+
+  if (bus.address == LAST_ADDRESS) {
+    bus.state = PROBE_DONE;
+  } else {
+    bus.address++;
+    bus.state = PROBE_IDLE;
+    bus.probeStart = micros();
+  }
+}
+
+// Calls the handler for every address that changed, then keeps the new bitmap
+uint16_t I2CScanner::report(uint8_t index) {
+  Bus &bus = buses[index];
+  uint16_t changes = 0;
+
+  for (uint8_t i = 0; i < I2C_SCANNER_BITMAP_SIZE; i++) {
+    uint8_t diff = bus.found[i] ^ bus.present[i];
+    for (uint8_t bit = 0; diff != 0; bit++, diff >>= 1) {
+      if (diff & 1) {
+        changes++;
+        if (handler != NULL) handler(index, (i << 3) | bit, (bus.found[i] >> bit) & 1);
+      }
+    }
+    bus.present[i] = bus.found[i];
+  }
+  return changes;
+}
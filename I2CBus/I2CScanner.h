@@ -0,0 +1,125 @@
+/*
+
+  I2CScanner: presence scan of up to I2C_SCANNER_MAX_BUSES buses at once
+
+  On the SAMD21 the buses are probed concurrently: the scanner writes the
+  address to every SERCOM and then polls them, so three buses take about
+  as long as one (126 probes at ~10 clocks each, ~13 ms at 100 kHz).
+  Elsewhere, or for a bus added without its SERCOM, the probes go through
+  TwoWire one by one.
+
+  Every probe has a timeout. A bus that times out (stuck line, clock held
+  low by a slave) is abandoned for the rest of the scan and flagged, so a
+  scan never takes longer than the probe time plus one timeout per bus.
+
+  The last presence bitmap is kept (16 bytes per bus) and only changes
+  are reported, through the change handler:
+
+    void onChange(uint8_t bus, uint8_t address, bool present) { ... }
+
+    scanner.addBus(&Wire0, SERCOM3);
+    scanner.addBus(&Wire1, SERCOM2);
+    scanner.addBus(&Wire2, SERCOM1);
+    scanner.setChangeHandler(onChange);
+    ...
+    scanner.scan();  // every call reports what appeared / disappeared
+
+  The TwoWire buses must have been started (begin() and pinPeripheral()).
+
+*/
+
+#ifndef I2CSCANNER_H
+#define I2CSCANNER_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define I2C_SCANNER_MAX_BUSES 4
+#define I2C_SCANNER_BITMAP_SIZE 16 // 128 addresses
+
+class I2CScanner {
+public:
+
+  typedef void (*ChangeHandler)(uint8_t bus, uint8_t address, bool present);
+
+  static const uint8_t FIRST_ADDRESS = 0x01;
+  static const uint8_t LAST_ADDRESS = 0x7E;
+  static const uint16_t DEFAULT_PROBE_TIMEOUT_US = 1000;
+
+  I2CScanner();
+
+  // Returns the bus index, or -1 if the table is full
+#if defined(ARDUINO_ARCH_SAMD)
+  int8_t addBus(TwoWire *wire, Sercom *sercom);
+#endif
+  int8_t addBus(TwoWire *wire);
+
+  void setChangeHandler(ChangeHandler handler) {
+    this->handler = handler;
+  }
+
+  void setProbeTimeout(uint16_t timeoutUs) {
+    probeTimeoutUs = timeoutUs;
+  }
+
+  // Scans all buses, reports changes, returns the number of changes
+  uint16_t scan();
+
+  bool isPresent(uint8_t bus, uint8_t address);
+  uint8_t deviceCount(uint8_t bus);
+
+  // The presence bitmap of a bus, bit (address & 7) of byte (address >> 3)
+  const uint8_t *getBitmap(uint8_t bus) {
+    return buses[bus].present;
+  }
+
+  // True if the last scan abandoned the bus after a probe timeout
+  bool hadTimeout(uint8_t bus) {
+    return buses[bus].timedOut;
+  }
+
+  uint8_t getBusCount() {
+    return busCount;
+  }
+
+  uint32_t getLastScanMicros() {
+    return lastScanUs;
+  }
+
+  uint32_t getMaxScanMicros() {
+    return maxScanUs;
+  }
+
+private:
+
+  enum ProbeState {
+    PROBE_IDLE,
+    PROBE_WAIT,
+    PROBE_DONE
+  };
+
+  struct Bus {
+    TwoWire *wire;
+#if defined(ARDUINO_ARCH_SAMD)
+    Sercom *sercom;
+#endif
+    uint8_t present[I2C_SCANNER_BITMAP_SIZE];
+    uint8_t found[I2C_SCANNER_BITMAP_SIZE];
+    uint8_t address;
+    ProbeState state;
+    uint32_t probeStart;
+    bool timedOut;
+  };
+
+  Bus buses[I2C_SCANNER_MAX_BUSES];
+  uint8_t busCount;
+  ChangeHandler handler;
+  uint16_t probeTimeoutUs;
+  uint32_t lastScanUs;
+  uint32_t maxScanUs;
+
+  void step(Bus &bus);
+  uint16_t report(uint8_t index);
+};
+
+#endif // I2CSCANNER_H
@@ -0,0 +1,419 @@
+/*
+ * Closed-loop pressure control on the DevBoard
+ *
+ * One control tick per DLC sample (Wire2, EOC A):
+ *   EOC rises (interrupt, timestamp) -> read the DLC -> PressurePID ->
+ *   pump PWM (pin 6) and valves (pins 5, 7, 9) -> start the next conversion.
+ * PID output above 0 is pump duty with the inlet valve A open, below 0
+ * the pump stops and vent valve B opens.
+ *
+ * No EOC within CONVERSION_TIMEOUT_US (a NACKed start command, a lost
+ * edge): the outputs go to the safe state (pump off, vent) and a new
+ * conversion is started. The PID and the waveform run on the measured
+ * EOC-to-EOC period (mean over the last second), not on the nominal
+ * SAMPLE_PERIOD_US.
+ *
+ * The setpoint comes from WaveformGenerator, one step per tick; send
+ * 's' (square), 'r' (ramp) or 'n' (sine) over Serial to switch the
+ * profile at the next breath boundary.
+ *
+ * Over-pressure interlock: every sample is checked against
+ * PRESSURE_MAX / PRESSURE_MIN before the PID runs. The limits sit inside
+ * the sensor range (SENSOR_MAX / SENSOR_MIN), a reading at the end of the
+ * range trips as well. Outside the limits,
+ * the pump pin is taken off the TCC and the vent valve opens in the same
+ * call, and the fault latches (send 'c' to clear it once the pressure is
+ * back within the limits). The same happens from the SafetyTimer (TC3)
+ * interrupt every SAFETY_TIMER_US, whatever loop() is doing: without a
+ * valid sample for STALE_US, or when a sample flagged by the EOC
+ * interrupt is not checked within CHECK_DEADLINE_US (loop() stuck, e.g.
+ * in Wire on a hanging bus). Faults are logged to FRAM (Wire2) from
+ * loop(), after the outputs are safe; the log is printed at startup and
+ * with 'l'. Such long work is done in pieces (one FRAM record, one line
+ * of output) with a waiting sample handled between them, so it never
+ * holds a sample past CHECK_DEADLINE_US.
+ *
+ * The time from the EOC edge to the last actuator write is measured
+ * every tick against LATENCY_BUDGET_US, the time from the EOC edge to the
+ * interlock decision against REACTION_BUDGET_US; once a second the
+ * pressure, the output and both delays (last / mean / max / overruns)
+ * are printed.
+ */
+
+#include <Wire.h>
+#include "wiring_private.h" // pinPeripheral() function
+#include <I2CBus.h>
+#include <AllSensors_DLC.h>
+#include <FRAM_MB85RC_I2C.h>
+#include <FRAM_CRC32.h>
+#include <ActuatorPWM.h>
+#include <OutputGroup.h>
+#include <PressurePID.h>
+#include <LatencyMeter.h>
+#include <PressureInterlock.h>
+#include <SafetyTimer.h>
+#include <WaveformGenerator.h>
+
+#define W2_SCL 13 // PA17 D13   SERCOM1.1 SERCOM3.1
+#define W2_SDA 11 // PA16 D11   SERCOM1.0 SERCOM3.0
+#define EOC_A  16
+
+#define pump   6
+#define valveA 5  // inlet
+#define valveB 7  // vent
+#define valveC 9
+
+#define SAMPLE_PERIOD_US  5000  // nominal DLC single conversion, until measured
+#define CONVERSION_TIMEOUT_US (2 * SAMPLE_PERIOD_US)
+#define LATENCY_BUDGET_US 500
+#define CMH2O 98067             // mPa
+#define INH2O 249089            // mPa
+
+// DLC-L01G: 1 inH2O gage. The output clips a little above full scale and
+// at -1/8 of it (raw 0); a reading there says nothing about the pressure
+#define SENSOR_MAX (1 * INH2O)
+#define SENSOR_MIN (-SENSOR_MAX / 8)
+
+// Limits inside the sensor range, with a margin
+#define PRESSURE_MAX (SENSOR_MAX * 9 / 10)
+#define PRESSURE_MIN (SENSOR_MIN / 2)
+static_assert((PRESSURE_MAX < SENSOR_MAX) && (PRESSURE_MIN > SENSOR_MIN), "pressure limits outside the sensor range");
+#define STALE_US     (4 * SAMPLE_PERIOD_US)
+#define I2C_DEADLINE_US   1000  // no new retry of a DLC read after this; a hanging bus is up to the SafetyTimer
+#define SAFETY_TIMER_US    500
+#define CHECK_DEADLINE_US (SAMPLE_PERIOD_US / 2) // EOC to interlock decision
+#define REACTION_BUDGET_US (CHECK_DEADLINE_US + SAFETY_TIMER_US)
+
+#define FAULT_LOG      0x0400   // count (+ CRC), then FAULT_LOG_SIZE records (+ CRC)
+#define FAULT_LOG_SIZE 16
+
+#define VALVE_INLET 0b001
+#define VALVE_VENT  0b010
+
+TwoWire Wire2(&sercom1, W2_SDA, W2_SCL);
+I2CBus bus2(&Wire2, W2_SDA, W2_SCL, PIO_SERCOM);
+AllSensors_DLC_L01G dlc(&Wire2, EOC_A);
+FRAM_MB85RC_I2C fram(&Wire2, MB85RC_DEFAULT_ADDRESS, false, FRAM_NO_WP_PIN); // pin 13 is W2_SCL
+
+ActuatorPWM pumpPWM(pump);
+typedef OutputGroup<valveA, valveB, valveC> Valves;
+
+PressurePID pid(SAMPLE_PERIOD_US);
+LatencyMeter latency(LATENCY_BUDGET_US);
+LatencyMeter period(SAMPLE_PERIOD_US + SAMPLE_PERIOD_US / 4); // EOC to EOC
+LatencyMeter reaction(REACTION_BUDGET_US);
+PressureInterlock interlock(PRESSURE_MAX, PRESSURE_MIN);
+SafetyTimer safety;
+
+struct FaultRecord {
+  uint32_t number;      // since the log was cleared
+  uint32_t uptimeMs;
+  int32_t pressure;     // mPa
+  uint16_t reactionUs;  // sample to outputs off
+  uint8_t cause;        // PressureInterlock::Cause
+  uint8_t reserved;
+};
+
+uint32_t faultCount = 0;
+volatile uint32_t tripMicros;
+
+// Scaled to the sensor: base 0.2 and peak 0.7 x full scale (0.5 / 1.8 cmH2O
+// on the L01G), under PRESSURE_MAX with room for overshoot. Clinical
+// pressures (PEEP 5, peak 20 cmH2O) need a sensor that covers them, e.g. a
+// DLC-L30G (30 inH2O) with SENSOR_MAX set to match
+#define SETPOINT_BASE (SENSOR_MAX / 5)
+#define SETPOINT_PEAK (SENSOR_MAX * 7 / 10)
+static_assert((SETPOINT_PEAK < PRESSURE_MAX) && (SETPOINT_BASE > PRESSURE_MIN), "setpoints outside the pressure limits");
+
+// 3 s breaths, 1 s inspiration (85 / 256)
+const WaveformProfile square = { WaveformTable<SquareShape<85>, 128>::values, 128, 3000000, SETPOINT_BASE, SETPOINT_PEAK - SETPOINT_BASE };
+const WaveformProfile ramp   = { WaveformTable<RampShape<85>, 128>::values,   128, 3000000, SETPOINT_BASE, SETPOINT_PEAK - SETPOINT_BASE };
+const WaveformProfile sine   = { WaveformTable<SineShape, 128>::values,       128, 3000000, SETPOINT_BASE, SETPOINT_PEAK - SETPOINT_BASE };
+
+WaveformGenerator waveform(SAMPLE_PERIOD_US);
+int32_t setpoint = 0;
+
+volatile bool sampleReady = false;
+volatile uint32_t eocMicros;
+
+uint32_t samplePeriodUs = SAMPLE_PERIOD_US;
+uint32_t lastEocMicros;
+bool consecutive = false;     // lastEocMicros is the EOC before this one
+uint32_t startMicros;         // last start command
+
+unsigned long lastReport = 0;
+
+void onEOC() {
+  eocMicros = micros();
+  sampleReady = true;
+  interlock.sampleArrived(eocMicros);
+}
+
+// From the TC3 interrupt: stale sensor, unchecked sample, and outputs
+// re-asserted while latched
+void safetyTick() {
+  interlock.checkStale(micros());
+}
+
+// From interlock.check() / checkStale(), in loop() or the TC3 interrupt:
+// bounded, no I2C, no waiting. Also called again while latched; the fault
+// is set after the first call, so tripMicros keeps the moment of the trip itself
+void tripOutputs() {
+  pumpPWM.forceOff();
+  Valves::write(VALVE_VENT);
+  if (!interlock.isTripped()) tripMicros = micros();
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  bus2.begin(400000);
+  bus2.setDeadline(I2C_DEADLINE_US);
+  dlc.setI2CBus(&bus2);
+  fram.setI2CBus(&bus2);
+  fram.begin();
+  printFaultLog();
+
+  Valves::begin();
+  pumpPWM.begin(20000);
+
+  pid.setGains(0.05, 0.5, 0);
+  pid.setOutputLimits(-65535, 65535);
+  pid.setDerivativeFilter(2);
+
+  interlock.setTripHandler(tripOutputs);
+  if (!interlock.setSensorRange(SENSOR_MAX, SENSOR_MIN)) {
+    Serial.println("pressure limits outside the sensor range, not starting");
+    while (true);
+  }
+  interlock.setStaleTimeout(STALE_US);
+  interlock.setCheckDeadline(CHECK_DEADLINE_US);
+  if (!safety.begin(SAFETY_TIMER_US, safetyTick)) {
+    Serial.println("SafetyTimer not started");
+  }
+
+  dlc.setPressureUnit(AllSensors_DLC::PASCAL);
+  pinMode(EOC_A, INPUT);
+  attachInterrupt(digitalPinToInterrupt(EOC_A), onEOC, RISING);
+
+  waveform.start(square);
+
+  if (!startConversion()) {
+    Serial.println("DLC not found");
+  }
+}
+
+void loop() {
+  serviceSample();
+
+  if (!sampleReady && ((uint32_t)(micros() - startMicros) > CONVERSION_TIMEOUT_US)) {
+    // no EOC: the start command was NACKed or the edge got lost
+    pumpPWM.setDuty(0);
+    Valves::write(VALVE_VENT);
+    consecutive = false;
+    startConversion();
+  }
+
+  safety.poll();
+
+  PressureInterlock::Fault fault;
+  noInterrupts();
+  bool tripped = interlock.takeFault(fault);
+  interrupts();
+  if (tripped) {
+    logFault(fault);
+  }
+
+  if (Serial.available()) {
+    switch (Serial.read()) {
+      case 's': waveform.queue(square); break;
+      case 'r': waveform.queue(ramp); break;
+      case 'n': waveform.queue(sine); break;
+      case 'c': clearFault(); break;
+      case 'l': printFaultLog(); break;
+    }
+  }
+
+  if (millis() - lastReport >= 1000) {
+    lastReport = millis();
+    report();
+    updateSamplePeriod();
+  }
+}
+
+// Between the pieces of long work in loop(): each piece (one FRAM record,
+// one line of output) is well under CHECK_DEADLINE_US, so a sample that
+// arrives during one is still checked in time
+void serviceSample() {
+  if (sampleReady) {
+    sampleReady = false;
+    controlTick();
+  }
+}
+
+void controlTick() {
+  if (consecutive) period.record(eocMicros - lastEocMicros);
+  lastEocMicros = eocMicros;
+  consecutive = true;
+
+  setpoint = waveform.next();
+
+  if (dlc.readData()) {
+    // no valid sample: fail safe, pump off and vent (latched by checkStale() if it lasts)
+    pumpPWM.setDuty(0);
+    Valves::write(VALVE_VENT);
+    noInterrupts();
+    interlock.sampleDropped();
+    interrupts();
+    reaction.record(micros() - eocMicros);
+  } else {
+    int32_t pressure = (int32_t)(dlc.pressure * 1000);
+    noInterrupts();
+    bool safe = interlock.check(pressure, eocMicros);
+    interrupts();
+    reaction.record(micros() - eocMicros);
+
+    if (safe) {
+      int32_t output = pid.update(setpoint, pressure);
+
+      if (output > 0) {
+        pumpPWM.setDuty(output);
+        Valves::write(VALVE_INLET);
+      } else {
+        pumpPWM.setDuty(0);
+        Valves::write(VALVE_VENT);
+      }
+    }
+  }
+  latency.record(micros() - eocMicros);
+
+  startConversion();
+}
+
+// On a NACK the outputs go safe, the timeout in loop() retries
+bool startConversion() {
+  startMicros = micros();
+  if (dlc.startMeasurement()) return true;
+
+  pumpPWM.setDuty(0);
+  Valves::write(VALVE_VENT);
+  return false;
+}
+
+// ki x dt, kd / dt and the waveform rate follow the measured conversion period
+void updateSamplePeriod() {
+  if (period.getCount() >= 100) {
+    samplePeriodUs = period.getMean();
+    pid.setSamplePeriod(samplePeriodUs);
+    waveform.setSamplePeriod(samplePeriodUs);
+  }
+  period.reset();
+}
+
+// Back to control, only with the pressure within the limits
+void clearFault() {
+  noInterrupts();
+  bool cleared = interlock.reset();
+  interrupts();
+  if (!cleared) {
+    Serial.println("fault not cleared: pressure out of limits");
+    return;
+  }
+  pid.reset(0);
+  pumpPWM.begin(20000);
+  consecutive = false;
+  Serial.println("fault cleared");
+
+  // a stale trip may have left the DLC without a conversion running
+  if (!startConversion()) {
+    Serial.println("DLC not responding, retrying");
+  }
+}
+
+uint16_t faultAddress(uint32_t number) {
+  return FAULT_LOG + sizeof(faultCount) + FRAM_CRC32_SIZE + (number % FAULT_LOG_SIZE) * (sizeof(FaultRecord) + FRAM_CRC32_SIZE);
+}
+
+void printFault(const FaultRecord &record) {
+  static const char *causes[] = { "none", "over-pressure", "under-pressure", "stale", "late" };
+
+  Serial.print("#");
+  Serial.print(record.number);
+  Serial.print(" at ");
+  Serial.print(record.uptimeMs);
+  Serial.print(" ms: ");
+  Serial.print((record.cause < 5) ? causes[record.cause] : "?");
+  Serial.print(", p (cmH2O) ");
+  Serial.print(record.pressure / (float)CMH2O, 2);
+  Serial.print(", reaction (us) ");
+  Serial.println(record.reactionUs);
+}
+
+// From loop(): the outputs are already off; one FRAM write per piece, see serviceSample()
+void logFault(const PressureInterlock::Fault &fault) {
+  FaultRecord record;
+  uint32_t reactionUs = tripMicros - fault.timeUs;
+
+  record.number = faultCount;
+  record.uptimeMs = millis();
+  record.pressure = fault.pressure;
+  record.reactionUs = (reactionUs > 0xFFFF) ? 0xFFFF : reactionUs;
+  record.cause = fault.cause;
+  record.reserved = 0;
+
+  fram.writeArrayCRC(faultAddress(faultCount), sizeof(record), (uint8_t *) &record);
+  serviceSample();
+  faultCount++;
+  fram.writeArrayCRC(FAULT_LOG, sizeof(faultCount), (uint8_t *) &faultCount);
+  serviceSample();
+
+  Serial.print("FAULT ");
+  printFault(record);
+}
+
+void printFaultLog() {
+  if (fram.readArrayCRC(FAULT_LOG, sizeof(faultCount), (uint8_t *) &faultCount) != 0) {
+    faultCount = 0; // never written
+  }
+  Serial.print("faults logged: ");
+  Serial.println(faultCount);
+
+  uint32_t first = (faultCount > FAULT_LOG_SIZE) ? faultCount - FAULT_LOG_SIZE : 0;
+  for (uint32_t n = first; n < faultCount; n++) {
+    serviceSample();
+    FaultRecord record;
+    if (fram.readArrayCRC(faultAddress(n), sizeof(record), (uint8_t *) &record) == 0) {
+      printFault(record);
+    }
+  }
+}
+
+void report() {
+  Serial.print("setpoint / p (cmH2O): ");
+  Serial.print(setpoint / (float)CMH2O, 2);
+  Serial.print(" / ");
+  Serial.print(dlc.pressure * 1000 / CMH2O, 2);
+  Serial.print(" period (us) mean / max: ");
+  Serial.print(period.getMean());
+  Serial.print(" / ");
+  Serial.print(period.getMax());
+  Serial.print(" out: ");
+  Serial.print(pid.getOutput());
+  serviceSample();
+  Serial.print(" latency (us) last / mean / max: ");
+  Serial.print(latency.getLast());
+  Serial.print(" / ");
+  Serial.print(latency.getMean());
+  Serial.print(" / ");
+  Serial.print(latency.getMax());
+  Serial.print(" overruns: ");
+  Serial.print(latency.getOverruns());
+  serviceSample();
+  Serial.print(" reaction (us) last / max: ");
+  Serial.print(reaction.getLast());
+  Serial.print(" / ");
+  Serial.print(reaction.getMax());
+  Serial.print(" overruns: ");
+  Serial.print(reaction.getOverruns());
+  Serial.println(interlock.isTripped() ? " TRIPPED" : "");
+}
@@ -0,0 +1,140 @@
+/*
+
+  Support for the Sensirion SDP6x0 differential pressure sensors, see SDP6x.h
+
+*/
+
+#include "SDP6x.h"
+#include "Arduino.h"
+#include "I2CBus.h"
+
+SDP6x::SDP6x(TwoWire *bus, Range range, ReadMode mode) {
+  this->bus = bus;
+  this->mode = mode;
+  status = NOT_READY;
+  pressure = 0;
+  pressure_mPa = 0;
+
+  // resolved once: raw * mPaPerCountQ16 >> 16 == raw * 1000 / scale
+  mPaPerCountQ16 = (((uint32_t) 1000 << 16) + (uint32_t) range / 2) / (uint32_t) range;
+}
+
+bool SDP6x::checkForSensor() {
+  if (i2c != nullptr) {
+    return i2c->probe(I2C_ADDRESS) == I2CBus::OK;
+  }
+
+  bus->beginTransmission(I2C_ADDRESS);
+  return bus->endTransmission() == 0;
+}
+
+bool SDP6x::softReset() {
+  resolution = 0;
+  return sendCommand(CMD_SOFT_RESET);
+}
+
+bool SDP6x::setResolution(uint8_t bits) {
+  if ((bits < 9) || (bits > 16)) return false;
+
+  uint16_t reg;
+  if (!readUserRegister(&reg)) return false;
+
+  reg = (reg & ~RESOLUTION_MASK) | ((uint16_t)(bits - 9) << RESOLUTION_SHIFT);
+  if (!sendCommand(CMD_WRITE_USER_REG, reg)) return false;
+
+  resolution = bits;
+  return true;
+}
+
+uint8_t SDP6x::getResolution() {
+  if (resolution == 0) {
+    uint16_t reg;
+    if (readUserRegister(&reg)) {
+      resolution = ((reg & RESOLUTION_MASK) >> RESOLUTION_SHIFT) + 9;
+    }
+  }
+  return resolution;
+}
+
+bool SDP6x::trigger() {
+  return sendCommand(CMD_TRIGGER);
+}
+
+bool SDP6x::readData() {
+  if ((mode == HOLD_MASTER) && !trigger()) {
+    status = BUS_ERROR;
+    return true;
+  }
+
+  uint16_t value;
+  status = (Status) readWord(&value, mode == POLLING);
+  if (status != OK) return true;
+
+  raw_p = (int16_t) value;
+  pressure_mPa = (int32_t)(((int64_t) raw_p * mPaPerCountQ16 + 0x8000) >> 16); // rounded
+  pressure = pressure_mPa * 0.001f;
+  return false;
+}
+
+uint8_t SDP6x::crc8(const uint8_t *data, uint8_t len) {
+  uint8_t crc = 0x00;
+  for (uint8_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+bool SDP6x::sendCommand(uint8_t command) {
+  if (i2c != nullptr) {
+    return i2c->write(I2C_ADDRESS, &command, 1) == I2CBus::OK;
+  }
+
+  bus->beginTransmission(I2C_ADDRESS);
+  bus->write(command);
+  return bus->endTransmission() == 0;
+}
+
+bool SDP6x::sendCommand(uint8_t command, uint16_t value) {
+  uint8_t bytes[3] = { command, (uint8_t)(value >> 8), (uint8_t)(value & 0xFF) };
+
+  if (i2c != nullptr) {
+    return i2c->write(I2C_ADDRESS, bytes, 3) == I2CBus::OK;
+  }
+
+  bus->beginTransmission(I2C_ADDRESS);
+  bus->write(bytes, 3);
+  return bus->endTransmission() == 0;
+}
+
+// Reads [MSB, LSB, CRC]; a NACK on the read header means the conversion is still running.
+// A poll is a single attempt: retrying a NACK only blocks until the next poll anyway
+uint8_t SDP6x::readWord(uint16_t *value, bool poll) {
+  uint8_t data[3];
+  uint8_t received;
+
+  if (i2c != nullptr) {
+    uint8_t result = poll ? i2c->readOnce(I2C_ADDRESS, data, 3) : i2c->read(I2C_ADDRESS, data, 3);
+    if (result == I2CBus::NACK_ADDRESS) return NOT_READY;
+    if (result != I2CBus::OK) return BUS_ERROR;
+    received = 3;
+  } else {
+    received = bus->requestFrom(I2C_ADDRESS, (uint8_t) 3);
+    for (uint8_t i = 0; i < received; i++) {
+      data[i] = bus->read();
+    }
+    if (received == 0) return NOT_READY;
+  }
+
+  if (received < 3) return BUS_ERROR;
+  if (crc8(data, 2) != data[2]) return CRC_ERROR;
+
+  *value = ((uint16_t) data[0] << 8) | data[1];
+  return OK;
+}
+
+bool SDP6x::readUserRegister(uint16_t *value) {
+  return sendCommand(CMD_READ_USER_REG) && (readWord(value) == OK);
+}
@@ -0,0 +1,119 @@
+/*
+
+  Support for the Sensirion SDP6x0 differential pressure sensors (SDP600 / SDP610, I2C)
+
+  See the datasheet:
+
+  https://www.sensirion.com/fileadmin/user_upload/customers/sensirion/Dokumente/8_Differential_Pressure/Datasheets/Sensirion_Differential_Pressure_Datasheet_SDP6x0series.pdf
+
+  * Resolution 9..16 bit in the advanced user register (bits 11:9):
+    every extra bit roughly doubles the conversion time.
+  * HOLD_MASTER: readData() triggers and reads in one go, the sensor
+    stretches SCL until the conversion is done (the bus is blocked).
+  * POLLING: trigger() starts a conversion and returns, readData() gets
+    the result later; while converting the sensor NACKs its read header
+    and readData() reports NOT_READY (the bus stays free in between).
+  * Every result word is followed by a CRC-8 (polynomial 0x31, init 0x00).
+  * The scale factor of the variant is resolved once in the constructor
+    and applied in fixed point: pressure_mPa = raw * (1000 / scale) in
+    Q16, no division per sample; pressure (Pa) is pressure_mPa times a
+    float constant.
+
+  readData() behaves like AllSensors_DLC::readData(): true on a failed
+  read, status tells why.
+
+*/
+
+#ifndef SDP6X_H
+#define SDP6X_H
+
+#include <stdint.h>
+#include <Wire.h>
+#pragma once
+
+class I2CBus;
+
+class SDP6x {
+public:
+
+  static const uint8_t I2C_ADDRESS = 0x40;
+
+  // Scale factors in counts per Pa, datasheet table 4
+  enum Range {
+    RANGE_500PA = 60,
+    RANGE_125PA = 240,
+    RANGE_25PA  = 1200
+  };
+
+  enum ReadMode {
+    HOLD_MASTER = 'H',
+    POLLING     = 'P'
+  };
+
+  enum Status {
+    OK          = 0,
+    NOT_READY   = 1,
+    CRC_ERROR   = 3,
+    BUS_ERROR   = 4
+  };
+
+  Status status;
+  float pressure;        // Pa
+  int32_t pressure_mPa;  // fixed point, milli Pa
+
+  SDP6x(TwoWire *bus, Range range = RANGE_500PA, ReadMode mode = HOLD_MASTER);
+
+  // Route transfers through an I2CBus (deadline, retries, bus recovery), it must wrap the same TwoWire.
+  // In HOLD_MASTER mode the I2CBus deadline must cover the conversion time.
+  void setI2CBus(I2CBus *i2c) {
+    this->i2c = i2c;
+  }
+
+  bool checkForSensor();
+  bool softReset();
+
+  // 9..16 bit, read-modify-write of the advanced user register
+  bool setResolution(uint8_t bits);
+  uint8_t getResolution();
+
+  void setReadMode(ReadMode mode) {
+    this->mode = mode;
+  }
+
+  // POLLING mode: start a conversion
+  bool trigger();
+
+  bool readData();
+
+  int16_t getRawPressure() {
+    return raw_p;
+  }
+
+  // CRC-8, polynomial 0x31, init 0x00
+  static uint8_t crc8(const uint8_t *data, uint8_t len);
+
+private:
+
+  static const uint8_t CMD_TRIGGER        = 0xF1;
+  static const uint8_t CMD_SOFT_RESET     = 0xFE;
+  static const uint8_t CMD_READ_USER_REG  = 0xE5;
+  static const uint8_t CMD_WRITE_USER_REG = 0xE4;
+
+  static const uint16_t RESOLUTION_MASK = 0x0E00; // bits 11:9, value = resolution - 9
+  static const uint8_t RESOLUTION_SHIFT = 9;
+
+  TwoWire *bus;
+  I2CBus *i2c = nullptr;
+  ReadMode mode;
+
+  int16_t raw_p = 0;
+  uint32_t mPaPerCountQ16;  // 1000 / scale in Q16
+  uint8_t resolution = 0;   // 0: not read from the sensor yet
+
+  bool sendCommand(uint8_t command);
+  bool sendCommand(uint8_t command, uint16_t value);
+  uint8_t readWord(uint16_t *value, bool poll = false); // Status
+  bool readUserRegister(uint16_t *value);
+};
+
+#endif // SDP6X_H
@@ -0,0 +1,133 @@
+/*
+
+  Support for the Sensirion SDP8xx differential pressure sensors, see SDP8xx.h
+
+*/
+
+#include "SDP8xx.h"
+#include "Arduino.h"
+#include "I2CBus.h"
+
+SDP8xx::SDP8xx(TwoWire *bus, uint8_t address) {
+  this->bus = bus;
+  this->address = address;
+  status = NOT_RUNNING;
+  pressure = 0;
+  temperature = 0;
+}
+
+bool SDP8xx::checkForSensor() {
+  if (i2c != nullptr) {
+    return i2c->probe(address) == I2CBus::OK;
+  }
+
+  bus->beginTransmission(address);
+  return bus->endTransmission() == 0;
+}
+
+bool SDP8xx::startContinuous(Compensation compensation, bool averageTillRead) {
+  uint16_t command;
+  if (compensation == MASS_FLOW) {
+    command = averageTillRead ? CMD_CONT_MASS_FLOW_AVG : CMD_CONT_MASS_FLOW;
+  } else {
+    command = averageTillRead ? CMD_CONT_DIFF_AVG : CMD_CONT_DIFF;
+  }
+
+  if (!sendCommand(command)) {
+    status = BUS_ERROR;
+    return false;
+  }
+  running = true;
+  started = millis();
+  scale = 0; // differs per compensation mode, read again with the first sample
+  status = NOT_READY;
+  return true;
+}
+
+bool SDP8xx::stopContinuous() {
+  running = false;
+  status = NOT_RUNNING;
+  return sendCommand(CMD_STOP_CONT);
+}
+
+bool SDP8xx::readData(bool withTemperature) {
+  if (!running) {
+    status = NOT_RUNNING;
+    return true;
+  }
+  if ((uint32_t)(millis() - started) < STARTUP_MS) {
+    status = NOT_READY;
+    return true;
+  }
+
+  // Only the words needed: the scale factor (third word) once per start
+  uint8_t words = (scale == 0) ? 3 : (withTemperature ? 2 : 1);
+  if (!readBytes(words * WORD_SIZE)) {
+    status = BUS_ERROR;
+    return true;
+  }
+  if (!checkWords(raw_data, words)) {
+    status = CRC_ERROR;
+    return true;
+  }
+
+  raw_p = word(raw_data);
+  if (words >= 2) {
+    raw_t = word(raw_data + WORD_SIZE);
+    temperature = (float) raw_t / TEMPERATURE_SCALE;
+  }
+  if (words == 3) {
+    scale = word(raw_data + 2 * WORD_SIZE);
+  }
+  if (scale <= 0) {
+    status = CRC_ERROR; // a valid CRC on a zero scale: not an SDP8xx frame
+    return true;
+  }
+
+  pressure = (float) raw_p / scale;
+  status = OK;
+  return false;
+}
+
+uint8_t SDP8xx::crc8(const uint8_t *data, uint8_t len) {
+  uint8_t crc = 0xFF;
+  for (uint8_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+bool SDP8xx::checkWords(const uint8_t *data, uint8_t words) {
+  uint8_t errors = 0;
+  for (uint8_t i = 0; i < words; i++, data += WORD_SIZE) {
+    errors |= crc8(data, 2) ^ data[2];
+  }
+  return errors == 0;
+}
+
+bool SDP8xx::sendCommand(uint16_t command) {
+  uint8_t bytes[2] = { (uint8_t)(command >> 8), (uint8_t)(command & 0xFF) };
+
+  if (i2c != nullptr) {
+    return i2c->write(address, bytes, 2) == I2CBus::OK;
+  }
+
+  bus->beginTransmission(address);
+  bus->write(bytes, 2);
+  return bus->endTransmission() == 0;
+}
+
+bool SDP8xx::readBytes(uint8_t len) {
+  if (i2c != nullptr) {
+    return i2c->read(address, raw_data, len) == I2CBus::OK;
+  }
+
+  uint8_t received = bus->requestFrom(address, len);
+  for (uint8_t i = 0; i < received; i++) {
+    raw_data[i] = bus->read();
+  }
+  return received == len;
+}
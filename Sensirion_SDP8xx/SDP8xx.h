@@ -0,0 +1,119 @@
+/*
+
+  Support for the Sensirion SDP8xx differential pressure sensors (SDP800 / SDP810, I2C)
+
+  See the datasheet:
+
+  https://www.sensirion.com/fileadmin/user_upload/customers/sensirion/Dokumente/8_Differential_Pressure/Datasheets/Sensirion_Differential_Pressure_Datasheet_SDP8xx_Digital.pdf
+
+  The sensor runs in continuous measurement mode: after startContinuous()
+  it measures every 0.5 ms on its own, so a sample costs one read
+  transaction and no trigger command. With averageTillRead the sensor
+  averages all internal samples since the previous read.
+
+  A full read is 9 bytes: pressure, temperature and scale factor, each a
+  16-bit word followed by its CRC-8. The read may stop after any word: the
+  scale factor is read once after the start and cached, later samples
+  read 3 bytes (pressure) or 6 bytes (pressure and temperature). The CRCs
+  of a read are checked together with checkWords().
+
+  Addresses: 0x25 SDP800-500Pa / SDP810-500Pa, 0x26 SDP801-500Pa / SDP811-500Pa.
+
+*/
+
+#ifndef SDP8XX_H
+#define SDP8XX_H
+
+#include <stdint.h>
+#include <Wire.h>
+#pragma once
+
+class I2CBus;
+
+class SDP8xx {
+public:
+
+  static const uint8_t ADDRESS_500PA = 0x25;
+  static const uint8_t ADDRESS_501PA = 0x26;
+
+  enum Compensation {
+    MASS_FLOW     = 'M', // temperature compensated for mass flow
+    DIFF_PRESSURE = 'P', // temperature compensated for differential pressure
+  };
+
+  enum Status {
+    OK          = 0,
+    NOT_READY   = 1, // first sample not yet available after startContinuous()
+    NOT_RUNNING = 2,
+    CRC_ERROR   = 3,
+    BUS_ERROR   = 4
+  };
+
+  // Datasheet table 11: 8 ms until the first measurement, then every 0.5 ms
+  static const uint16_t STARTUP_MS = 8;
+  static const uint16_t TEMPERATURE_SCALE = 200;
+
+  Status status;
+  float pressure;     // Pa
+  float temperature;  // degrees C
+
+  SDP8xx(TwoWire *bus, uint8_t address = ADDRESS_500PA);
+
+  // Route transfers through an I2CBus (deadline, retries, bus recovery), it must wrap the same TwoWire.
+  void setI2CBus(I2CBus *i2c) {
+    this->i2c = i2c;
+  }
+
+  bool checkForSensor();
+
+  bool startContinuous(Compensation compensation = DIFF_PRESSURE, bool averageTillRead = true);
+  bool stopContinuous();
+
+  // Reads one sample, returns true on a failed read (status tells why), like AllSensors_DLC::readData()
+  bool readData(bool withTemperature = false);
+
+  int16_t getRawPressure() {
+    return raw_p;
+  }
+
+  // Counts per Pa, 0 before the first sample
+  int16_t getScaleFactor() {
+    return scale;
+  }
+
+  // CRC-8, polynomial 0x31, init 0xFF
+  static uint8_t crc8(const uint8_t *data, uint8_t len);
+  // Checks 'words' consecutive [MSB, LSB, CRC] triplets
+  static bool checkWords(const uint8_t *data, uint8_t words);
+
+private:
+
+  static const uint16_t CMD_CONT_MASS_FLOW_AVG = 0x3603;
+  static const uint16_t CMD_CONT_MASS_FLOW     = 0x3608;
+  static const uint16_t CMD_CONT_DIFF_AVG      = 0x3615;
+  static const uint16_t CMD_CONT_DIFF          = 0x361E;
+  static const uint16_t CMD_STOP_CONT          = 0x3FF9;
+
+  static const uint8_t WORD_SIZE = 3; // MSB, LSB, CRC
+
+  TwoWire *bus;
+  I2CBus *i2c = nullptr;
+  uint8_t address;
+
+  bool running = false;
+  uint32_t started = 0;
+
+  uint8_t raw_data[9];
+  int16_t raw_p = 0;
+  int16_t raw_t = 0;
+  int16_t scale = 0;
+
+  bool sendCommand(uint16_t command);
+  bool readBytes(uint8_t len);
+
+  static int16_t word(const uint8_t *data) {
+    return (int16_t)(((uint16_t) data[0] << 8) | data[1]);
+  }
+};
+
+#endif // SDP8XX_H
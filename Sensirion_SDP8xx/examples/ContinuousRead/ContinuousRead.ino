@@ -0,0 +1,41 @@
+/*
+
+    SDP800-500Pa on Wire1 in continuous mode, averaging till read.
+    One 3-byte read per sample, pressure in Pa.
+
+*/
+
+#include <Wire.h>
+#include "wiring_private.h" // pinPeripheral() function
+#include <SDP8xx.h>
+
+#define W1_SCL 3 // PA09  D3    SERCOM0.1 SERCOM2.1
+#define W1_SDA 4 // PA08  D4    SERCOM0.0 SERCOM2.0
+
+TwoWire Wire1(&sercom2, W1_SDA, W1_SCL);
+
+SDP8xx sensor(&Wire1, SDP8xx::ADDRESS_500PA);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  Wire1.begin();
+  Wire1.setClock(400000);
+  pinPeripheral(W1_SDA, PIO_SERCOM_ALT);
+  pinPeripheral(W1_SCL, PIO_SERCOM_ALT);
+
+  if (!sensor.checkForSensor() || !sensor.startContinuous(SDP8xx::DIFF_PRESSURE, true)) {
+    Serial.println("SDP8xx not found");
+  }
+}
+
+void loop() {
+  if (!sensor.readData()) {
+    Serial.println(sensor.pressure, 3);
+  } else if (sensor.status != SDP8xx::NOT_READY) {
+    Serial.print("status: ");
+    Serial.println(sensor.status);
+  }
+  delay(10);
+}
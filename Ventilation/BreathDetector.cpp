@@ -0,0 +1,113 @@
+/*
+
+  BreathDetector: streaming inspiration / expiration segmentation, see BreathDetector.h
+
+*/
+
+#include "BreathDetector.h"
+#include <string.h>
+
+BreathDetector::BreathDetector() {
+  minSwing = DEFAULT_MIN_SWING;
+  fraction = DEFAULT_FRACTION;
+  confirmSamples = DEFAULT_CONFIRM_SAMPLES;
+  handler = NULL;
+  reset();
+}
+
+void BreathDetector::reset() {
+  started = false;
+  phase = UNKNOWN;
+  pending = 0;
+  breathCount = 0;
+  memset(&current, 0, sizeof(current));
+  memset(&last, 0, sizeof(last));
+}
+
+// Once per phase switch: the only multiply
+void BreathDetector::setThresholds() {
+  int32_t swing = peak - trough;
+  if (swing < minSwing) swing = minSwing;
+
+  int32_t margin = (int32_t)(((int64_t) swing * fraction) >> 8);
+  riseThreshold = trough + margin;
+  fallThreshold = trough + swing - margin;
+}
+
+BreathDetector::Event BreathDetector::update(int32_t pressure, uint32_t timestamp) {
+  if (!started) {
+    started = true;
+    trough = pressure;
+    peak = pressure + minSwing;
+    phaseMin = pressure;
+    phaseMax = pressure;
+    setThresholds();
+  }
+
+  if (pressure > phaseMax) phaseMax = pressure;
+  if (pressure < phaseMin) {
+    phaseMin = pressure;
+    if (phase == UNKNOWN) {
+      // Started during an inspiration: the first trough is still ahead
+      trough = pressure;
+      peak = pressure + minSwing;
+      setThresholds();
+    }
+  }
+
+  if (phase == INSPIRATION) {
+    current.inspirationSamples++;
+  } else if (phase == EXPIRATION) {
+    current.expirationSamples++;
+  }
+
+  bool beyond = (phase == INSPIRATION) ? (pressure < fallThreshold) : (pressure > riseThreshold);
+  if (!beyond) {
+    pending = 0;
+    return NONE;
+  }
+
+  if (pending++ == 0) pendingTimestamp = timestamp;
+  if (pending < confirmSamples) return NONE;
+
+  pending = 0;
+  Event event = switchPhase(pressure);
+  setThresholds();
+
+  if (handler != NULL) handler(event, pendingTimestamp);
+  return event;
+}
+
+// The confirming samples were counted in the old phase, they belong to the new one
+BreathDetector::Event BreathDetector::switchPhase(int32_t pressure) {
+  if (phase == INSPIRATION) {
+    peak += (phaseMax - peak) >> ADAPT_SHIFT;
+
+    current.peak = phaseMax;
+    current.expirationStart = pendingTimestamp;
+    current.inspirationSamples -= confirmSamples;
+    current.expirationSamples = confirmSamples;
+
+    phaseMin = pressure;
+    phase = EXPIRATION;
+    return EXPIRATION_START;
+  }
+
+  if (phase == EXPIRATION) {
+    trough += (phaseMin - trough) >> ADAPT_SHIFT;
+
+    current.trough = phaseMin;
+    current.end = pendingTimestamp;
+    current.expirationSamples -= confirmSamples;
+    current.number = ++breathCount;
+    last = current;
+  }
+
+  memset(&current, 0, sizeof(current));
+  current.start = pendingTimestamp;
+  current.inspirationSamples = confirmSamples;
+
+  phaseMax = pressure;
+  phase = INSPIRATION;
+  return BREATH_START;
+}
@@ -0,0 +1,149 @@
+/*
+
+  BreathDetector: streaming inspiration / expiration segmentation of a pressure signal
+
+  A two-state machine with hysteresis on the airway pressure (e.g. the DLC):
+
+    EXPIRATION -> INSPIRATION  when pressure > rise threshold
+    INSPIRATION -> EXPIRATION  when pressure < fall threshold
+
+  for confirmSamples consecutive samples. The thresholds adapt: peak and
+  trough of every phase are tracked and averaged over the breaths (EMA,
+  1/4), and the thresholds sit a fraction of the swing inside them,
+
+    rise = trough + fraction x swing,  fall = peak - fraction x swing
+
+  with the swing never taken smaller than minSwing, so noise on a flat
+  signal does not trigger. Thresholds are only recomputed at a phase
+  switch: update() is a handful of compares per sample, bounded, and can
+  run in the acquisition path.
+
+  Events carry the timestamp of the first sample beyond the threshold
+  (not the one that confirmed it), in whatever unit update() is fed:
+  a sample counter or micros() taken at acquisition.
+
+    void onBreath(BreathDetector::Event event, uint32_t timestamp) {
+      if (event == BreathDetector::BREATH_START) integrator.beginBreath();
+      if (event == BreathDetector::EXPIRATION_START) integrator.beginExpiration();
+    }
+
+    detector.setEventHandler(onBreath);
+    ...
+    detector.update(pressure_mPa, micros());
+
+  BREATH_START also closes the previous breath, getLastBreath() then
+  holds its summary.
+
+*/
+
+#ifndef BREATHDETECTOR_H
+#define BREATHDETECTOR_H
+
+#include <stdint.h>
+
+class BreathDetector {
+public:
+
+  enum Event {
+    NONE             = 0,
+    BREATH_START     = 1,
+    EXPIRATION_START = 2
+  };
+
+  enum Phase {
+    UNKNOWN     = 0, // before the first breath start
+    INSPIRATION = 1,
+    EXPIRATION  = 2
+  };
+
+  struct Breath {
+    uint32_t number;
+    uint32_t start;              // timestamps
+    uint32_t expirationStart;
+    uint32_t end;
+    int32_t peak;                // mPa
+    int32_t trough;              // mPa
+    uint32_t inspirationSamples;
+    uint32_t expirationSamples;
+  };
+
+  typedef void (*EventHandler)(Event event, uint32_t timestamp);
+
+  static const int32_t DEFAULT_MIN_SWING = 196133; // 2 cmH2O in mPa
+  static const uint8_t DEFAULT_FRACTION = 64;      // 1/4 of the swing, Q8
+  static const uint8_t DEFAULT_CONFIRM_SAMPLES = 3;
+
+  BreathDetector();
+
+  void setMinSwing(int32_t swing) {
+    minSwing = swing;
+  }
+
+  // Threshold distance from peak / trough, in 1/256 of the swing (1..127)
+  void setThresholdFraction(uint8_t fraction) {
+    this->fraction = fraction;
+  }
+
+  void setConfirmSamples(uint8_t samples) {
+    confirmSamples = (samples > 0) ? samples : 1;
+  }
+
+  void setEventHandler(EventHandler handler) {
+    this->handler = handler;
+  }
+
+  void reset();
+
+  // Pressure in mPa, returns the event this sample completed (if any)
+  Event update(int32_t pressure, uint32_t timestamp);
+
+  Phase getPhase() {
+    return phase;
+  }
+
+  int32_t getRiseThreshold() {
+    return riseThreshold;
+  }
+
+  int32_t getFallThreshold() {
+    return fallThreshold;
+  }
+
+  uint32_t getBreathCount() {
+    return breathCount;
+  }
+
+  const Breath &getLastBreath() {
+    return last;
+  }
+
+private:
+
+  static const uint8_t ADAPT_SHIFT = 2;
+
+  int32_t minSwing;
+  uint8_t fraction;
+  uint8_t confirmSamples;
+  EventHandler handler;
+
+  bool started;
+  Phase phase;
+  int32_t peak;        // averaged over breaths
+  int32_t trough;
+  int32_t riseThreshold;
+  int32_t fallThreshold;
+  int32_t phaseMax;
+  int32_t phaseMin;
+
+  uint8_t pending;     // consecutive samples beyond the threshold
+  uint32_t pendingTimestamp;
+
+  uint32_t breathCount;
+  Breath current;
+  Breath last;
+
+  void setThresholds();
+  Event switchPhase(int32_t pressure);
+};
+
+#endif // BREATHDETECTOR_H
@@ -0,0 +1,110 @@
+/*
+
+  FlowEngine: flow from differential pressure, in fixed point, see FlowEngine.h
+
+*/
+
+#include "FlowEngine.h"
+#include <math.h>
+
+#define LUT_FIRST 16 // x >> 26 of a normalised operand is 16..63
+
+// round(sqrt(i << 26)) for i = 16..64
+static const uint32_t sqrtTable[] = {
+  32768, 33776, 34756, 35708, 36636, 37540, 38424, 39287, 40132, 40960,
+  41771, 42567, 43348, 44115, 44869, 45611, 46341, 47059, 47767, 48465,
+  49152, 49830, 50499, 51159, 51811, 52454, 53090, 53719, 54340, 54954,
+  55561, 56162, 56756, 57344, 57926, 58503, 59073, 59639, 60199, 60753,
+  61303, 61848, 62388, 62924, 63455, 63982, 64504, 65022, 65536
+};
+
+// Shifts x left by an even amount until x >= 2^30, returns half the shift
+static inline uint8_t normalise(uint32_t &x) {
+  uint8_t shift = 0;
+  if (x < 0x00010000UL) { x <<= 16; shift += 8; }
+  if (x < 0x01000000UL) { x <<= 8;  shift += 4; }
+  if (x < 0x10000000UL) { x <<= 4;  shift += 2; }
+  if (x < 0x40000000UL) { x <<= 2;  shift += 1; }
+  return shift;
+}
+
+FlowEngine::FlowEngine() {
+  coefficient = 0;
+  maxPressure = DEFAULT_MAX_PRESSURE;
+  zeroOffset = 0;
+  method = SQRT_LUT;
+  kMantissa = 0;
+  kShift = 0;
+}
+
+void FlowEngine::setOrifice(float orificeMm, float pipeMm, float cd, float density) {
+  double d = orificeMm / 1000.0;
+  double beta = orificeMm / pipeMm;
+  double area = M_PI / 4.0 * d * d;
+
+  // m3/s per sqrt(Pa) to uL/s per sqrt(mPa)
+  double k = cd * area / sqrt(1.0 - beta * beta * beta * beta) * sqrt(2.0 / density);
+  setCoefficient(k * 1e9 / sqrt(1000.0));
+}
+
+void FlowEngine::setVenturi(float throatMm, float pipeMm, float cd, float density) {
+  setOrifice(throatMm, pipeMm, cd, density);
+}
+
+void FlowEngine::setCoefficient(float k) {
+  coefficient = k;
+  resolve();
+}
+
+void FlowEngine::setMaxPressure(int32_t maxPressure) {
+  this->maxPressure = maxPressure;
+  resolve();
+}
+
+// Mantissa in [2^14, 2^15): times a 16-bit root it stays below 2^31
+void FlowEngine::resolve() {
+  kShift = 0;
+  while ((kShift < 31) && (coefficient * ldexp(1.0, kShift) < 16384.0)) kShift++;
+  kMantissa = (uint32_t)(coefficient * ldexp(1.0, kShift) + 0.5);
+  if (kMantissa > 32767) kMantissa = 32767; // coefficient beyond 2^15 uL/s per sqrt(mPa)
+}
+
+int32_t FlowEngine::compute(int32_t dp) {
+  dp -= zeroOffset;
+
+  bool negative = dp < 0;
+  uint32_t magnitude = negative ? -dp : dp;
+  if (magnitude > (uint32_t) maxPressure) magnitude = maxPressure;
+
+  if (magnitude == 0) return 0;
+
+  // sqrt(magnitude) = root / 2^shift, root in [2^15, 2^16)
+  uint8_t shift = normalise(magnitude);
+  uint32_t root = (method == SQRT_EXACT) ? sqrtExact(magnitude) : sqrtLut(magnitude);
+
+  shift += kShift;
+  if (shift >= 32) return 0;
+  int32_t flow = (root * kMantissa + (((uint32_t) 1 << shift) >> 1)) >> shift;
+  return negative ? -flow : flow;
+}
+
+uint32_t FlowEngine::sqrtExact(uint32_t x) {
+  uint32_t root = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit != 0) {
+    if (x >= root + bit) {
+      x -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return root;
+}
+
+uint32_t FlowEngine::sqrtLut(uint32_t x) {
+  uint8_t i = (x >> 26) - LUT_FIRST;
+  uint32_t fraction = (x >> 10) & 0xFFFF;
+  return sqrtTable[i] + (((sqrtTable[i + 1] - sqrtTable[i]) * fraction) >> 16);
+}
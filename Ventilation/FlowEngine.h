@@ -0,0 +1,98 @@
+/*
+
+  FlowEngine: flow from differential pressure, in fixed point
+
+  Orifice plate and venturi follow the same model,
+
+    Q = K * sign(dp) * sqrt(|dp|),  K = Cd * A / sqrt(1 - beta^4) * sqrt(2 / rho)
+
+  with A the orifice / throat area and beta = d / D. K is resolved once,
+  when the geometry is set, into a 15-bit mantissa and a shift. The square
+  root works on |dp| normalised to [2^30, 2^32) and yields 16 significant
+  bits at any pressure; the normalisation shift is folded into the shift
+  of K, so compute() costs one square root, one 32-bit multiply and one
+  shift: no float, no division (the Cortex-M0+ has neither an FPU nor a
+  divider), and no loss of resolution at low flow.
+
+  Two square roots:
+    * SQRT_EXACT: digit-by-digit, 16 iterations of shift / compare / subtract
+    * SQRT_LUT:   49-entry table with linear interpolation, ~1e-4 relative
+                  error, a fraction of the cycles (see extras/flow_bench)
+
+  Units: dp in mPa (SDP6x::pressure_mPa, or Pa * 1000 for SDP8xx / DLC),
+  flow in uL/s (1 L/min = 16667 uL/s).
+
+    FlowEngine flow;
+    flow.setOrifice(8.0, 15.0);        // 8 mm orifice in a 15 mm tube
+    flow.setZeroOffset(offset_mPa);    // from a zero-flow calibration
+    ...
+    int32_t q = flow.compute(sdp.pressure_mPa);
+
+  No Arduino dependency: extras/flow_bench runs it on a host against a
+  double-precision reference.
+
+*/
+
+#ifndef FLOWENGINE_H
+#define FLOWENGINE_H
+
+#include <stdint.h>
+
+#define FLOW_AIR_DENSITY 1.204 // kg/m3, dry air at 20 degC, 1013 hPa
+
+class FlowEngine {
+public:
+
+  enum SqrtMethod {
+    SQRT_EXACT = 'E',
+    SQRT_LUT   = 'L'
+  };
+
+  static const int32_t DEFAULT_MAX_PRESSURE = 500000; // mPa, SDP610-500Pa / SDP800-500Pa full scale
+
+  FlowEngine();
+
+  // Diameters in mm, density in kg/m3
+  void setOrifice(float orificeMm, float pipeMm, float cd = 0.61, float density = FLOW_AIR_DENSITY);
+  void setVenturi(float throatMm, float pipeMm, float cd = 0.98, float density = FLOW_AIR_DENSITY);
+
+  // Calibrated coefficient, uL/s per sqrt(mPa)
+  void setCoefficient(float k);
+
+  float getCoefficient() {
+    return coefficient;
+  }
+
+  // Inputs beyond +/- maxPressure are clamped
+  void setMaxPressure(int32_t maxPressure);
+
+  // Subtracted from every input, e.g. the reading at zero flow
+  void setZeroOffset(int32_t offset) {
+    zeroOffset = offset;
+  }
+
+  void setSqrtMethod(SqrtMethod method) {
+    this->method = method;
+  }
+
+  // dp in mPa, returns uL/s with the sign of dp
+  int32_t compute(int32_t dp);
+
+private:
+
+  float coefficient;
+  int32_t maxPressure;
+  int32_t zeroOffset;
+  SqrtMethod method;
+
+  uint32_t kMantissa; // coefficient * 2^kShift, 15 bits
+  uint8_t kShift;
+
+  void resolve();
+
+  // Operand normalised to [2^30, 2^32), returns floor(sqrt(x)) in [2^15, 2^16)
+  static uint32_t sqrtExact(uint32_t x);
+  static uint32_t sqrtLut(uint32_t x);
+};
+
+#endif // FLOWENGINE_H
@@ -0,0 +1,30 @@
+/*
+
+  LatencyMeter: worst case, mean and budget overruns of a measured delay, see LatencyMeter.h
+
+*/
+
+#include "LatencyMeter.h"
+
+LatencyMeter::LatencyMeter(uint32_t budgetUs) {
+  this->budgetUs = budgetUs;
+  reset();
+}
+
+void LatencyMeter::reset() {
+  last = 0;
+  min = 0xFFFFFFFFUL;
+  max = 0;
+  total = 0;
+  count = 0;
+  overruns = 0;
+}
+
+void LatencyMeter::record(uint32_t elapsedUs) {
+  last = elapsedUs;
+  if (elapsedUs < min) min = elapsedUs;
+  if (elapsedUs > max) max = elapsedUs;
+  if (elapsedUs > budgetUs) overruns++;
+  total += elapsedUs;
+  count++;
+}
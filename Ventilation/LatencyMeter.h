@@ -0,0 +1,70 @@
+/*
+
+  LatencyMeter: worst case, mean and budget overruns of a measured delay
+
+    LatencyMeter latency(500);               // budget 500 us
+    ...
+    latency.record(micros() - sampleMicros); // e.g. sensor EOC to actuator write
+
+  O(1) per record, no Arduino dependency (the caller takes the time).
+
+*/
+
+#ifndef LATENCYMETER_H
+#define LATENCYMETER_H
+
+#include <stdint.h>
+
+class LatencyMeter {
+public:
+
+  LatencyMeter(uint32_t budgetUs);
+
+  void record(uint32_t elapsedUs);
+  void reset();
+
+  void setBudget(uint32_t budgetUs) {
+    this->budgetUs = budgetUs;
+  }
+
+  uint32_t getBudget() {
+    return budgetUs;
+  }
+
+  uint32_t getLast() {
+    return last;
+  }
+
+  uint32_t getMin() {
+    return min;
+  }
+
+  uint32_t getMax() {
+    return max;
+  }
+
+  uint32_t getMean() {
+    return (count > 0) ? (uint32_t)(total / count) : 0;
+  }
+
+  uint32_t getCount() {
+    return count;
+  }
+
+  // Records above the budget
+  uint32_t getOverruns() {
+    return overruns;
+  }
+
+private:
+
+  uint32_t budgetUs;
+  uint32_t last;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint32_t count;
+  uint32_t overruns;
+};
+
+#endif // LATENCYMETER_H
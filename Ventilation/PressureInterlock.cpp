@@ -0,0 +1,113 @@
+/*
+
+  PressureInterlock: latching over- / under-pressure trip, see PressureInterlock.h
+
+*/
+
+#include "PressureInterlock.h"
+
+PressureInterlock::PressureInterlock(int32_t maxPressure, int32_t minPressure) {
+  sensorMax = INT32_MAX;
+  sensorMin = INT32_MIN;
+  setLimits(maxPressure, minPressure);
+  staleTimeoutUs = 0;
+  checkDeadlineUs = 0;
+  handler = nullptr;
+
+  fault.cause = NONE;
+  fault.pressure = 0;
+  fault.timeUs = 0;
+  unlogged = false;
+  trips = 0;
+
+  sampled = false;
+  lastPressure = 0;
+  lastSampleUs = 0;
+  pending = false;
+  pendingUs = 0;
+}
+
+bool PressureInterlock::setLimits(int32_t maxPressure, int32_t minPressure) {
+  this->maxPressure = maxPressure;
+  this->minPressure = minPressure;
+  return limitsInRange();
+}
+
+bool PressureInterlock::setSensorRange(int32_t sensorMax, int32_t sensorMin) {
+  this->sensorMax = sensorMax;
+  this->sensorMin = sensorMin;
+  return limitsInRange();
+}
+
+// Each limit strictly inside the range, unless both are off
+bool PressureInterlock::limitsInRange() {
+  return ((maxPressure < sensorMax) || (sensorMax == INT32_MAX)) &&
+         ((minPressure > sensorMin) || (sensorMin == INT32_MIN));
+}
+
+void PressureInterlock::sampleArrived(uint32_t sampleUs) {
+  pendingUs = sampleUs;
+  pending = true;
+}
+
+void PressureInterlock::sampleDropped() {
+  pending = false;
+}
+
+// Handler first, bookkeeping after: nothing delays the outputs
+bool PressureInterlock::check(int32_t pressure, uint32_t sampleUs) {
+  if ((pressure > maxPressure) || (pressure >= sensorMax)) {
+    trip(OVER_PRESSURE, pressure, sampleUs);
+  } else if ((pressure < minPressure) || (pressure <= sensorMin)) {
+    trip(UNDER_PRESSURE, pressure, sampleUs);
+  } else if (fault.cause != NONE) {
+    if (handler != nullptr) handler();
+  }
+
+  sampled = true;
+  lastPressure = pressure;
+  lastSampleUs = sampleUs;
+  pending = false;
+  return fault.cause == NONE;
+}
+
+bool PressureInterlock::checkStale(uint32_t nowUs) {
+  if ((checkDeadlineUs > 0) && pending && ((uint32_t)(nowUs - pendingUs) > checkDeadlineUs)) {
+    pending = false;
+    trip(LATE, lastPressure, pendingUs);
+  } else if ((staleTimeoutUs > 0) && sampled && ((uint32_t)(nowUs - lastSampleUs) > staleTimeoutUs)) {
+    trip(STALE, lastPressure, nowUs);
+    lastSampleUs = nowUs; // once per timeout
+  } else if (fault.cause != NONE) {
+    if (handler != nullptr) handler(); // undoes a write that raced with the trip
+  }
+  return fault.cause == NONE;
+}
+
+bool PressureInterlock::reset() {
+  if (sampled && ((lastPressure > maxPressure) || (lastPressure >= sensorMax) ||
+                  (lastPressure < minPressure) || (lastPressure <= sensorMin))) return false;
+  fault.cause = NONE;
+  sampled = false;
+  pending = false;
+  return true;
+}
+
+bool PressureInterlock::takeFault(Fault &fault) {
+  if (!unlogged) return false;
+  fault = this->fault;
+  unlogged = false;
+  return true;
+}
+
+// While latched only the handler runs: the first fault is the one kept
+void PressureInterlock::trip(uint8_t cause, int32_t pressure, uint32_t timeUs) {
+  if (handler != nullptr) handler();
+  if (fault.cause != NONE) return;
+
+  fault.cause = cause;
+  fault.pressure = pressure;
+  fault.timeUs = timeUs;
+  unlogged = true;
+  trips++;
+}
@@ -0,0 +1,146 @@
+/*
+
+  PressureInterlock: latching over- / under-pressure trip, checked on every sample
+
+    * check() compares each sample with the limits; the first sample
+      outside them calls the trip handler right away, from the same call,
+      before check() returns
+    * with setSensorRange(), a reading at or beyond the sensor's range
+      trips as well, whatever the limits: a clipped sensor no longer
+      tells the pressure
+    * the fault latches: every later check() calls the handler again
+      (outputs stay off whatever the control code does) and returns false,
+      until reset() with the pressure back within the limits
+    * checkStale() trips when no valid sample arrived for the stale
+      timeout (a dead sensor is an unmonitored pressure), and when a
+      sample announced with sampleArrived() was neither checked nor
+      dropped within the check deadline (LATE: loop() is stuck, e.g. in
+      a TwoWire call); while latched it calls the handler again as well
+    * logging is left to the caller, outside the time-critical path:
+      takeFault() hands out each new fault once (e.g. to write it to FRAM
+      from loop())
+
+  The handler has to be short and bounded, e.g. direct PORT writes:
+
+    void trip() {
+      pumpPWM.forceOff();            // pin off the TCC, low now
+      Valves::write(VALVE_VENT);
+    }
+
+    PressureInterlock interlock(35 * CMH2O, -5 * CMH2O);  // mPa
+    interlock.setTripHandler(trip);
+    ...
+    if (!interlock.check(pressure, eocMicros)) return;   // tripped
+
+  With checkStale() from a timer interrupt every P (SafetyTimer) and
+  sampleArrived() from the sensor's EOC interrupt, the outputs are safe
+  at most deadline + P after a sample that is out of range or never
+  checked, whatever loop() does; a sample that is checked in time is
+  acted on in check() itself. Call check(), sampleDropped(), takeFault()
+  and reset() with the timer interrupt masked (noInterrupts()).
+
+  No Arduino dependency, the caller passes the times.
+
+*/
+
+#ifndef PRESSUREINTERLOCK_H
+#define PRESSUREINTERLOCK_H
+
+#include <stdint.h>
+
+class PressureInterlock {
+public:
+
+  enum Cause {
+    NONE           = 0,
+    OVER_PRESSURE  = 1,
+    UNDER_PRESSURE = 2,
+    STALE          = 3,
+    LATE           = 4
+  };
+
+  struct Fault {
+    uint8_t cause;
+    int32_t pressure;   // mPa, the sample that tripped (last valid one for STALE / LATE)
+    uint32_t timeUs;    // sample time, detection time for STALE
+  };
+
+  typedef void (*TripHandler)();
+
+  // Limits in mPa, INT32_MIN: no lower limit
+  PressureInterlock(int32_t maxPressure, int32_t minPressure = INT32_MIN);
+
+  // False if the limits are not inside the sensor range
+  bool setLimits(int32_t maxPressure, int32_t minPressure = INT32_MIN);
+
+  // mPa, the readings the sensor can give; false if the limits are not
+  // inside it (the limit could never be seen: refuse to run)
+  bool setSensorRange(int32_t sensorMax, int32_t sensorMin = INT32_MIN);
+
+  void setTripHandler(TripHandler handler) {
+    this->handler = handler;
+  }
+
+  // 0 = off
+  void setStaleTimeout(uint32_t timeoutUs) {
+    staleTimeoutUs = timeoutUs;
+  }
+
+  // 0 = off: sampleArrived() to check() / sampleDropped() at most deadlineUs
+  void setCheckDeadline(uint32_t deadlineUs) {
+    checkDeadlineUs = deadlineUs;
+  }
+
+  // From the EOC interrupt: a sample is waiting to be read and checked
+  void sampleArrived(uint32_t sampleUs);
+  // The sample could not be read (the caller makes the outputs safe itself)
+  void sampleDropped();
+
+  // False if tripped, now or before
+  bool check(int32_t pressure, uint32_t sampleUs);
+  bool checkStale(uint32_t nowUs);
+
+  // Clears the latch if the last sample is within the limits; the stale
+  // timeout restarts with the next sample
+  bool reset();
+
+  bool isTripped() {
+    return fault.cause != NONE;
+  }
+
+  const Fault &getFault() {
+    return fault;
+  }
+
+  // True once per fault, for logging it
+  bool takeFault(Fault &fault);
+
+  uint32_t getTrips() {
+    return trips;
+  }
+
+private:
+
+  int32_t maxPressure;
+  int32_t minPressure;
+  int32_t sensorMax;
+  int32_t sensorMin;
+  uint32_t staleTimeoutUs;
+  uint32_t checkDeadlineUs;
+  TripHandler handler;
+
+  Fault fault;
+  bool unlogged;
+  uint32_t trips;
+
+  bool sampled;
+  int32_t lastPressure;
+  uint32_t lastSampleUs;
+  volatile bool pending;
+  volatile uint32_t pendingUs;
+
+  bool limitsInRange();
+  void trip(uint8_t cause, int32_t pressure, uint32_t timeUs);
+};
+
+#endif // PRESSUREINTERLOCK_H
@@ -0,0 +1,101 @@
+/*
+
+  PressurePID: fixed-point PID with anti-windup and feed-forward, see PressurePID.h
+
+*/
+
+#include "PressurePID.h"
+
+static int32_t toQ24(double value) {
+  double q = value * (double)(1L << 24);
+  if (q > 2147483647.0) return 2147483647L;
+  if (q < -2147483647.0) return -2147483647L;
+  return (int32_t)((q < 0) ? q - 0.5 : q + 0.5);
+}
+
+PressurePID::PressurePID(uint32_t samplePeriodUs) {
+  this->samplePeriodUs = samplePeriodUs;
+  kp = ki = kd = ffGain = 0;
+  ffOffset = 0;
+  outMin = -65535;
+  outMax = 65535;
+  derivativeShift = 0;
+  resolve();
+  reset();
+}
+
+void PressurePID::setSamplePeriod(uint32_t samplePeriodUs) {
+  this->samplePeriodUs = samplePeriodUs;
+  resolve();
+}
+
+void PressurePID::setGains(float kp, float ki, float kd) {
+  this->kp = kp;
+  this->ki = ki;
+  this->kd = kd;
+  resolve();
+}
+
+void PressurePID::setOutputLimits(int32_t min, int32_t max) {
+  outMin = min;
+  outMax = max;
+}
+
+void PressurePID::setFeedForward(float gain, int32_t offset) {
+  ffGain = gain;
+  ffOffset = offset;
+  resolve();
+}
+
+// The only float: once per configuration change
+void PressurePID::resolve() {
+  double dt = samplePeriodUs / 1e6;
+  kpQ = toQ24(kp);
+  kiQ = toQ24(ki * dt);
+  kdQ = (dt > 0) ? toQ24(kd / dt) : 0;
+  ffGainQ = toQ24(ffGain);
+}
+
+void PressurePID::reset(int32_t output) {
+  this->output = output;
+  integral = (int64_t) output * GAIN_ONE;
+  derivative = 0;
+  first = true;
+  saturated = false;
+}
+
+int32_t PressurePID::update(int32_t setpoint, int32_t measurement) {
+  const int64_t maxQ = (int64_t) outMax * GAIN_ONE;
+  const int64_t minQ = (int64_t) outMin * GAIN_ONE;
+
+  int32_t error = setpoint - measurement;
+
+  int64_t sum = (int64_t) kpQ * error;
+  sum += (int64_t) ffGainQ * setpoint + (int64_t) ffOffset * GAIN_ONE;
+
+  // on the measurement: no kick on a setpoint step
+  int64_t d = first ? 0 : -(int64_t) kdQ * (measurement - lastMeasurement);
+  derivative = (derivativeShift == 0) ? d : derivative + ((d - derivative) >> derivativeShift);
+  lastMeasurement = measurement;
+  first = false;
+  sum += derivative;
+
+  // Integrate only if that does not push a clamped output further out
+  int64_t next = integral + (int64_t) kiQ * error;
+  if (next > maxQ) next = maxQ;
+  if (next < minQ) next = minQ;
+  if (!(((sum + next) > maxQ) && (error > 0)) && !(((sum + next) < minQ) && (error < 0))) integral = next;
+  sum += integral;
+
+  saturated = true;
+  if (sum > maxQ) {
+    sum = maxQ;
+  } else if (sum < minQ) {
+    sum = minQ;
+  } else {
+    saturated = false;
+  }
+
+  output = (int32_t)((sum + GAIN_ONE / 2) >> GAIN_SHIFT);
+  return output;
+}
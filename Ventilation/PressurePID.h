@@ -0,0 +1,98 @@
+/*
+
+  PressurePID: fixed-point PID with anti-windup and feed-forward, one update per sample
+
+    output = feed-forward + P + I + D, clamped to [min, max]
+
+    * gains are set as float (output units per mPa, per mPa s, per mPa/s)
+      and resolved once, with the sample period, into Q24 integers:
+      update() is four 32 x 32 -> 64 bit multiplies and adds, no float,
+      no division, the same number of operations every sample
+    * D acts on the measurement, not on the error, so a setpoint step
+      gives no derivative kick; optionally smoothed (EMA, 1 / 2^shift)
+    * anti-windup by conditional integration: while the output is
+      clamped, the integral only moves in the direction that brings it
+      back, and it never leaves [min, max] itself
+    * feed-forward: gain x setpoint + offset (e.g. the pump duty that
+      holds a pressure open loop), so the integral only carries the rest
+
+  Units: pressure in mPa, output in whatever the actuator takes (e.g.
+  -65535 .. 65535: pump duty above 0, vent below).
+
+    PressurePID pid(5000);                // 5 ms per DLC sample
+    pid.setGains(0.05, 0.2, 0.0005);
+    pid.setOutputLimits(-65535, 65535);
+    ...
+    int32_t out = pid.update(setpoint, pressure_mPa);
+
+*/
+
+#ifndef PRESSUREPID_H
+#define PRESSUREPID_H
+
+#include <stdint.h>
+
+class PressurePID {
+public:
+
+  PressurePID(uint32_t samplePeriodUs);
+
+  void setSamplePeriod(uint32_t samplePeriodUs);
+  void setGains(float kp, float ki, float kd);
+  void setOutputLimits(int32_t min, int32_t max);
+
+  // output += gain x setpoint + offset
+  void setFeedForward(float gain, int32_t offset);
+
+  // EMA on the derivative term, 0 = off
+  void setDerivativeFilter(uint8_t shift) {
+    derivativeShift = shift;
+  }
+
+  // Starts over from output (bumpless transfer from manual control)
+  void reset(int32_t output = 0);
+
+  int32_t update(int32_t setpoint, int32_t measurement);
+
+  int32_t getOutput() {
+    return output;
+  }
+
+  // True if the last output was clamped
+  bool isSaturated() {
+    return saturated;
+  }
+
+  int32_t getIntegral() {
+    return (int32_t)(integral >> GAIN_SHIFT);
+  }
+
+private:
+
+  static const uint8_t GAIN_SHIFT = 24;
+  static const int64_t GAIN_ONE = (int64_t) 1 << GAIN_SHIFT; // to Q24 by multiplying: << on a negative value is undefined
+
+  uint32_t samplePeriodUs;
+  float kp, ki, kd, ffGain;
+
+  int32_t kpQ;       // Q24, per sample
+  int32_t kiQ;
+  int32_t kdQ;
+  int32_t ffGainQ;
+  int32_t ffOffset;
+
+  int32_t outMin;
+  int32_t outMax;
+  uint8_t derivativeShift;
+
+  int64_t integral;  // output units, Q24
+  int64_t derivative;
+  int32_t lastMeasurement;
+  bool first;
+  int32_t output;
+  bool saturated;
+
+  void resolve();
+};
+
+#endif // PRESSUREPID_H
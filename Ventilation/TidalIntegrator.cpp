@@ -0,0 +1,110 @@
+/*
+
+  TidalIntegrator: tidal volume, pressures and compliance per breath, see TidalIntegrator.h
+
+*/
+
+#include "TidalIntegrator.h"
+#include <string.h>
+
+#define CMH2O_MPA 98067 // 1 cmH2O in mPa
+
+TidalIntegrator::TidalIntegrator(uint32_t samplePeriodUs) {
+  setSamplePeriod(samplePeriodUs);
+  plateauFlow = DEFAULT_PLATEAU_FLOW;
+  driftCorrection = true;
+  handler = NULL;
+  decimation = 1;
+  reset();
+}
+
+void TidalIntegrator::setSamplePeriod(uint32_t samplePeriodUs) {
+  periodQ32 = (uint32_t)(((uint64_t) samplePeriodUs << 32) / 1000000);
+}
+
+void TidalIntegrator::setLoopHandler(LoopHandler handler, uint8_t decimation) {
+  this->handler = handler;
+  this->decimation = (decimation > 0) ? decimation : 1;
+  decimationCount = 0;
+}
+
+void TidalIntegrator::reset() {
+  phase = IDLE;
+  flowOffset = 0;
+  lastPressure = 0;
+  breathCount = 0;
+  decimationCount = 0;
+  memset(&last, 0, sizeof(last));
+  startBreath();
+}
+
+void TidalIntegrator::startBreath() {
+  volume = 0;
+  inspiredVolume = 0;
+  plateauSamples = 0;
+  peepEma = lastPressure;
+
+  memset(&current, 0, sizeof(current));
+  current.peakPressure = lastPressure;
+  current.flowOffset = flowOffset;
+}
+
+void TidalIntegrator::sample(int32_t flow, int32_t pressure) {
+  flow -= flowOffset;
+  volume += (int64_t) flow * periodQ32;
+  lastPressure = pressure;
+
+  if (pressure > current.peakPressure) current.peakPressure = pressure;
+
+  if (phase == INSPIRATION) {
+    current.inspirationSamples++;
+    if ((flow <= plateauFlow) && (flow >= -plateauFlow)) {
+      plateauEma = (plateauSamples++ == 0) ? pressure : plateauEma + ((pressure - plateauEma) >> EMA_SHIFT);
+    }
+  } else if (phase == EXPIRATION) {
+    current.expirationSamples++;
+    peepEma += (pressure - peepEma) >> EMA_SHIFT;
+  }
+
+  if ((handler != NULL) && (++decimationCount >= decimation)) {
+    decimationCount = 0;
+    handler(getVolume(), pressure);
+  }
+}
+
+void TidalIntegrator::beginExpiration() {
+  if (phase != INSPIRATION) return;
+
+  inspiredVolume = volume;
+  current.inspiredVolume = (int32_t)(volume >> 32);
+  current.plateauPressure = (plateauSamples > 0) ? plateauEma : lastPressure;
+  peepEma = lastPressure;
+  phase = EXPIRATION;
+}
+
+bool TidalIntegrator::beginBreath() {
+  bool complete = (phase == EXPIRATION);
+
+  if (complete) {
+    current.expiredVolume = (int32_t)((inspiredVolume - volume) >> 32);
+    current.peep = peepEma;
+
+    int32_t drivingPressure = current.plateauPressure - current.peep;
+    if (drivingPressure > 0) {
+      current.compliance = (int32_t)((int64_t) current.inspiredVolume * CMH2O_MPA / drivingPressure);
+    }
+
+    // What is left of the volume is the integrated flow offset: uL (Q32) / s (Q32) = uL/s
+    uint32_t samples = current.inspirationSamples + current.expirationSamples;
+    if (driftCorrection && (samples > 0)) {
+      flowOffset += (int32_t)(volume / ((int64_t) samples * periodQ32)) / 2;
+    }
+
+    current.number = ++breathCount;
+    last = current;
+  }
+
+  startBreath();
+  phase = INSPIRATION;
+  return complete;
+}
@@ -0,0 +1,140 @@
+/*
+
+  TidalIntegrator: tidal volume, pressures and compliance per breath, in fixed point
+
+  Fed with one flow / pressure pair per sample (fixed sample period) and
+  told where the breath boundaries are (beginBreath() at the start of
+  inspiration, beginExpiration() at the switch), e.g. by BreathDetector.
+  Every call is O(1): a sample costs one 32 x 32 -> 64 bit multiply for
+  the volume and a few compares, the divisions (compliance, drift) run
+  once per breath.
+
+    * volume: uL in Q32, sum of flow * sample period, restarts at 0 with
+      every breath; getVolume() with the last pressure is a PV-loop point,
+      the loop handler gets every nth point
+    * peak: highest pressure of the breath
+    * plateau: average (EMA, 1/8) of the inspiratory pressure while |flow|
+      is below the plateau flow (end-inspiratory pause), the last
+      inspiratory pressure if there was no pause
+    * PEEP: EMA (1/8) of the expiratory pressure at the end of the breath
+    * compliance: inspired volume / (plateau - PEEP), in uL/cmH2O
+
+  Drift correction: in a closed circuit the volume returns to 0 at the
+  end of every breath, what remains is a flow offset (sensor zero drift)
+  integrated over the breath. At each boundary it is turned into a flow
+  offset estimate; half of it is added to the offset that is subtracted
+  from every following flow sample.
+
+  Units: flow in uL/s (FlowEngine), pressure in mPa, volume in uL.
+
+*/
+
+#ifndef TIDALINTEGRATOR_H
+#define TIDALINTEGRATOR_H
+
+#include <stdint.h>
+
+class TidalIntegrator {
+public:
+
+  enum Phase {
+    IDLE        = 0, // before the first beginBreath()
+    INSPIRATION = 1,
+    EXPIRATION  = 2
+  };
+
+  struct Breath {
+    uint32_t number;
+    int32_t inspiredVolume;      // uL
+    int32_t expiredVolume;       // uL
+    int32_t peakPressure;        // mPa
+    int32_t plateauPressure;     // mPa
+    int32_t peep;                // mPa
+    int32_t compliance;          // uL/cmH2O (mL/cmH2O x 1000), 0 if plateau <= PEEP
+    uint32_t inspirationSamples;
+    uint32_t expirationSamples;
+    int32_t flowOffset;          // uL/s, subtracted during this breath
+  };
+
+  typedef void (*LoopHandler)(int32_t volume, int32_t pressure);
+
+  static const int32_t DEFAULT_PLATEAU_FLOW = 1667; // uL/s, 0.1 L/min
+
+  TidalIntegrator(uint32_t samplePeriodUs);
+
+  void setSamplePeriod(uint32_t samplePeriodUs);
+
+  // |flow| at or below this counts as end-inspiratory pause
+  void setPlateauFlow(int32_t flow) {
+    plateauFlow = flow;
+  }
+
+  void setDriftCorrection(bool enabled) {
+    driftCorrection = enabled;
+  }
+
+  // Called with every nth PV-loop point (volume uL, pressure mPa), NULL to stop
+  void setLoopHandler(LoopHandler handler, uint8_t decimation = 1);
+
+  void reset();
+
+  void sample(int32_t flow, int32_t pressure);
+
+  // Start of inspiration, closes the running breath; true if it was complete (had an expiration)
+  bool beginBreath();
+  void beginExpiration();
+
+  Phase getPhase() {
+    return phase;
+  }
+
+  // uL since the start of the breath
+  int32_t getVolume() {
+    return (int32_t)(volume >> 32);
+  }
+
+  int32_t getFlowOffset() {
+    return flowOffset;
+  }
+
+  void setFlowOffset(int32_t offset) {
+    flowOffset = offset;
+  }
+
+  uint32_t getBreathCount() {
+    return breathCount;
+  }
+
+  const Breath &getLastBreath() {
+    return last;
+  }
+
+private:
+
+  static const uint8_t EMA_SHIFT = 3;
+
+  uint32_t periodQ32;   // sample period in s, Q32
+  int32_t plateauFlow;
+  bool driftCorrection;
+
+  LoopHandler handler;
+  uint8_t decimation;
+  uint8_t decimationCount;
+
+  Phase phase;
+  int64_t volume;            // uL, Q32
+  int64_t inspiredVolume;    // volume at beginExpiration()
+  int32_t flowOffset;
+  int32_t lastPressure;
+  int32_t plateauEma;
+  int32_t peepEma;
+  uint32_t plateauSamples;
+  uint32_t breathCount;
+
+  Breath current;
+  Breath last;
+
+  void startBreath();
+};
+
+#endif // TIDALINTEGRATOR_H
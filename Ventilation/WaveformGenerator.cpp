@@ -0,0 +1,136 @@
+/*
+
+  WaveformGenerator: setpoint profiles played back from precomputed tables, see WaveformGenerator.h
+
+*/
+
+#include "WaveformGenerator.h"
+#include <math.h>
+
+WaveformGenerator::WaveformGenerator(uint32_t samplePeriodUs) {
+  this->samplePeriodUs = samplePeriodUs;
+  profile.table = 0;
+  profile.length = 0;
+  profile.breathUs = 0;
+  profile.base = 0;
+  profile.amplitude = 0;
+  playing = false;
+  queued = false;
+  breathStart = false;
+  breathCount = 0;
+  phase = 0;
+  step = 0;
+  end = 0;
+}
+
+void WaveformGenerator::setSamplePeriod(uint32_t samplePeriodUs) {
+  this->samplePeriodUs = samplePeriodUs;
+  resolve();
+}
+
+// Table entries per sample, Q16: the only division, once per profile.
+// Rounded up, so a breath of a whole number of samples wraps on time.
+void WaveformGenerator::resolve() {
+  end = (uint32_t) profile.length << 16;
+  step = (profile.breathUs > 0) ? (uint32_t)((((uint64_t) profile.length << 16) * samplePeriodUs + profile.breathUs - 1) / profile.breathUs) : 0;
+}
+
+// A breath must last at least one sample: the phase steps by at most one table per next()
+bool WaveformGenerator::isPlayable(const WaveformProfile &profile) {
+  return (profile.table != 0) && (profile.length > 0) && (profile.breathUs >= samplePeriodUs);
+}
+
+void WaveformGenerator::start(const WaveformProfile &profile) {
+  queued = false;
+  if (!isPlayable(profile)) {
+    playing = false;
+    return;
+  }
+
+  this->profile = profile;
+  resolve();
+  phase = end; // the first next() starts breath 1
+  playing = true;
+  breathStart = false;
+  breathCount = 0;
+}
+
+void WaveformGenerator::queue(const WaveformProfile &profile) {
+  if (!playing) {
+    start(profile);
+    return;
+  }
+  if (!isPlayable(profile)) return;
+  queued = false;
+  pending = profile;
+  queued = true;
+}
+
+int32_t WaveformGenerator::next() {
+  if (!playing) return profile.base;
+
+  breathStart = false;
+  if (phase >= end) {
+    phase %= end; // more than one table only after setSamplePeriod() made the breath shorter than a sample
+    breathStart = true;
+    breathCount++;
+
+    if (queued) {
+      // carry the part of a sample that ran past the boundary over to the new profile
+      uint32_t oldStep = step;
+      profile = pending;
+      queued = false;
+      resolve();
+      phase = (oldStep > 0) ? (uint32_t)(((uint64_t) phase * step) / oldStep) : 0;
+    }
+  }
+
+  uint16_t i = phase >> 16;
+  uint16_t j = (i + 1 < profile.length) ? i + 1 : 0;
+  int32_t fraction = phase & 0xFFFF;
+  int32_t value = profile.table[i] + (((profile.table[j] - profile.table[i]) * fraction) >> 16);
+
+  phase += step;
+  return profile.base + (int32_t)(((int64_t) profile.amplitude * value) >> 15);
+}
+
+void WaveformGenerator::fillSquare(int16_t *table, uint16_t length, uint8_t inspiration) {
+  for (uint16_t i = 0; i < length; i++) {
+    table[i] = ((uint32_t) i * 256 < (uint32_t) inspiration * length) ? WAVEFORM_FULL : 0;
+  }
+}
+
+void WaveformGenerator::fillRamp(int16_t *table, uint16_t length, uint8_t inspiration) {
+  uint32_t rampLength = ((uint32_t) inspiration * length) / 256;
+  for (uint16_t i = 0; i < length; i++) {
+    table[i] = (i < rampLength) ? (int16_t)(((uint32_t) i * WAVEFORM_FULL) / rampLength) : 0;
+  }
+}
+
+void WaveformGenerator::fillSine(int16_t *table, uint16_t length) {
+  for (uint16_t i = 0; i < length; i++) {
+    table[i] = (int16_t)((1.0 - cos(2.0 * M_PI * i / length)) / 2.0 * WAVEFORM_FULL + 0.5);
+  }
+}
+
+void WaveformGenerator::resample(const int32_t *samples, uint16_t count, int16_t *table, uint16_t length,
+                                 int32_t *base, int32_t *amplitude) {
+  int32_t min = samples[0];
+  int32_t max = samples[0];
+  for (uint16_t i = 1; i < count; i++) {
+    if (samples[i] < min) min = samples[i];
+    if (samples[i] > max) max = samples[i];
+  }
+  *base = min;
+  *amplitude = max - min;
+
+  for (uint16_t i = 0; i < length; i++) {
+    // position in the recording, Q16, linear interpolation between samples
+    uint32_t position = (uint32_t)(((uint64_t) i * count << 16) / length);
+    uint16_t k = position >> 16;
+    uint16_t l = (k + 1 < count) ? k + 1 : 0;
+    int64_t value = samples[k] + (((int64_t)(samples[l] - samples[k]) * (position & 0xFFFF)) >> 16);
+
+    table[i] = (*amplitude > 0) ? (int16_t)(((value - min) * WAVEFORM_FULL) / *amplitude) : 0;
+  }
+}
@@ -0,0 +1,182 @@
+/*
+
+  WaveformGenerator: setpoint profiles played back from precomputed tables
+
+  A profile is one breath: a table of Q15 values (0 = base, 32767 = base
+  + amplitude), the breath duration, base and amplitude (mPa, or uL/s for
+  a flow profile). next() is called once per control tick at a fixed
+  sample period and returns the setpoint, linearly interpolated between
+  table entries: a phase accumulator (table index in Q16) steps by
+  length x period / breath, resolved when the profile starts, so a
+  sample is one add, one table lookup and two multiplies.
+
+  Tables:
+    * at compile time, in flash, for the standard shapes:
+
+        WaveformTable<SquareShape<102>, 128>::values   // 40 % inspiration (102 / 256)
+        WaveformTable<RampShape<102>, 128>::values     // rising ramp during inspiration, then base
+        WaveformTable<SineShape, 128>::values          // (1 - cos) / 2
+
+    * at run time, in RAM: fillSquare(), fillRamp(), fillSine(), and
+      resample() for a recorded trace (any length and scale, e.g. read
+      from FRAM_TimeSeries) into a table plus its base and amplitude.
+      Tables in RAM can be kept in FRAM (writeArray / readArray) and
+      read back before they are queued.
+
+  Switching: start() changes the profile at once; queue() takes effect
+  at the end of the running breath, so the waveform never jumps in the
+  middle of a breath. atBreathStart() tells the caller a new breath (and
+  possibly a new profile) began with the last next().
+
+    WaveformProfile square = { WaveformTable<SquareShape<102>, 128>::values, 128, 3000000, 5 * CMH2O, 15 * CMH2O };
+    WaveformGenerator waveform(5000);   // 5 ms ticks
+    waveform.start(square);
+    ...
+    int32_t setpoint = waveform.next();
+
+  No Arduino dependency.
+
+*/
+
+#ifndef WAVEFORMGENERATOR_H
+#define WAVEFORMGENERATOR_H
+
+#include <stdint.h>
+
+#define WAVEFORM_FULL 32767
+
+struct WaveformProfile {
+  const int16_t *table;  // Q15, one breath
+  uint16_t length;       // entries
+  uint32_t breathUs;     // duration of one breath
+  int32_t base;          // value at table entry 0
+  int32_t amplitude;     // value at WAVEFORM_FULL is base + amplitude
+};
+
+// Shapes for WaveformTable: at(i, n) is entry i of an n-entry table
+
+// On for inspiration / 256 of the breath
+template <uint8_t Inspiration>
+struct SquareShape {
+  static constexpr int16_t at(uint16_t i, uint16_t n) {
+    return ((uint32_t) i * 256 < (uint32_t) Inspiration * n) ? WAVEFORM_FULL : 0;
+  }
+};
+
+// Rising linearly during inspiration / 256 of the breath, then back to base
+template <uint8_t Inspiration>
+struct RampShape {
+  static constexpr int16_t at(uint16_t i, uint16_t n) {
+    return ((uint32_t) i * 256 < (uint32_t) Inspiration * n)
+           ? (int16_t)(((uint32_t) i * 256 * WAVEFORM_FULL) / ((uint32_t) Inspiration * n))
+           : 0;
+  }
+};
+
+// Taylor series of cos, term n + 1 = term n x -x^2 / ((2n + 1)(2n + 2)); 15 terms on [-pi, pi]
+constexpr double waveformCosSeries(double x2, int n, double term) {
+  return (n >= 15) ? 0.0 : term + waveformCosSeries(x2, n + 1, term * -x2 / ((2 * n + 1) * (2 * n + 2)));
+}
+
+constexpr double waveformCos(double x) {
+  return waveformCosSeries(x * x, 0, 1.0);
+}
+
+// (1 - cos) / 2 over the breath: smooth from base to peak and back; cos(t) = -cos(t - pi) keeps the series on [-pi, pi]
+struct SineShape {
+  static constexpr int16_t at(uint16_t i, uint16_t n) {
+    return (int16_t)((1.0 + waveformCos(2.0 * 3.14159265358979323846 * i / n - 3.14159265358979323846)) / 2.0 * WAVEFORM_FULL + 0.5);
+  }
+};
+
+template <uint16_t... I>
+struct WaveformIndices {};
+
+template <uint16_t N, uint16_t... I>
+struct MakeWaveformIndices : MakeWaveformIndices<N - 1, N - 1, I...> {};
+
+template <uint16_t... I>
+struct MakeWaveformIndices<0, I...> {
+  typedef WaveformIndices<I...> type;
+};
+
+// The table of a shape, built by the compiler, in flash
+template <typename Shape, uint16_t N, typename Indices = typename MakeWaveformIndices<N>::type>
+struct WaveformTable;
+
+template <typename Shape, uint16_t N, uint16_t... I>
+struct WaveformTable<Shape, N, WaveformIndices<I...> > {
+  static constexpr int16_t values[N] = { Shape::at(I, N)... };
+};
+
+template <typename Shape, uint16_t N, uint16_t... I>
+constexpr int16_t WaveformTable<Shape, N, WaveformIndices<I...> >::values[N];
+
+class WaveformGenerator {
+public:
+
+  WaveformGenerator(uint32_t samplePeriodUs);
+
+  void setSamplePeriod(uint32_t samplePeriodUs);
+
+  // Now, from the start of a breath; stops on a profile without a table or
+  // with a breath shorter than the sample period
+  void start(const WaveformProfile &profile);
+
+  // At the next breath boundary (at once if nothing is playing), ignored
+  // for a profile start() would refuse
+  void queue(const WaveformProfile &profile);
+
+  // Next setpoint, base if nothing is playing
+  int32_t next();
+
+  // True if the last next() started a new breath
+  bool atBreathStart() {
+    return breathStart;
+  }
+
+  bool isPlaying() {
+    return playing;
+  }
+
+  bool hasQueued() {
+    return queued;
+  }
+
+  uint32_t getBreathCount() {
+    return breathCount;
+  }
+
+  const WaveformProfile &getProfile() {
+    return profile;
+  }
+
+  // RAM tables, inspiration in 1/256 of the breath
+  static void fillSquare(int16_t *table, uint16_t length, uint8_t inspiration);
+  static void fillRamp(int16_t *table, uint16_t length, uint8_t inspiration);
+  static void fillSine(int16_t *table, uint16_t length);
+
+  // One recorded breath (count samples) to a table, base / amplitude from its minimum / maximum
+  static void resample(const int32_t *samples, uint16_t count, int16_t *table, uint16_t length,
+                       int32_t *base, int32_t *amplitude);
+
+private:
+
+  uint32_t samplePeriodUs;
+
+  WaveformProfile profile;
+  WaveformProfile pending;
+  bool playing;
+  volatile bool queued;
+  bool breathStart;
+  uint32_t breathCount;
+
+  uint32_t phase;   // table index, Q16
+  uint32_t step;
+  uint32_t end;     // length, Q16
+
+  void resolve();
+  bool isPlayable(const WaveformProfile &profile);
+};
+
+#endif // WAVEFORMGENERATOR_H
@@ -0,0 +1,110 @@
+/*
+
+    Breath monitor: airway pressure from the DLC (Wire2, one single
+    conversion per tick), flow from an SDP800 over an orifice (Wire1),
+    sampled every 10 ms.
+
+    BreathDetector segments the pressure into breaths and drives the
+    TidalIntegrator, which prints a summary line per breath:
+    Vt in / out (mL), peak / plateau / PEEP (cmH2O), compliance (mL/cmH2O).
+
+*/
+
+#include <Wire.h>
+#include "wiring_private.h" // pinPeripheral() function
+#include <AllSensors_DLC.h>
+#include <SDP8xx.h>
+#include <FlowEngine.h>
+#include <TidalIntegrator.h>
+#include <BreathDetector.h>
+
+#define W1_SCL 3 // PA09  D3    SERCOM0.1 SERCOM2.1
+#define W1_SDA 4 // PA08  D4    SERCOM0.0 SERCOM2.0
+
+#define W2_SCL 13 // PA17 D13   SERCOM1.1 SERCOM3.1
+#define W2_SDA 11 // PA16 D11   SERCOM1.0 SERCOM3.0
+#define EOC_A  16
+
+#define SAMPLE_PERIOD_US 10000
+#define CMH2O 98066.5 // mPa
+
+TwoWire Wire1(&sercom2, W1_SDA, W1_SCL);
+TwoWire Wire2(&sercom1, W2_SDA, W2_SCL);
+
+AllSensors_DLC_L01G dlc(&Wire2, EOC_A);
+SDP8xx sdp(&Wire1, SDP8xx::ADDRESS_500PA);
+
+FlowEngine flow;
+TidalIntegrator integrator(SAMPLE_PERIOD_US);
+BreathDetector detector;
+
+unsigned long nextSample;
+uint32_t sampleCount = 0;
+
+void onBreath(BreathDetector::Event event, uint32_t timestamp) {
+  if (event == BreathDetector::EXPIRATION_START) {
+    integrator.beginExpiration();
+  } else if (event == BreathDetector::BREATH_START) {
+    if (integrator.beginBreath()) printBreath(integrator.getLastBreath());
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  Wire1.begin();
+  Wire1.setClock(400000);
+  pinPeripheral(W1_SDA, PIO_SERCOM_ALT);
+  pinPeripheral(W1_SCL, PIO_SERCOM_ALT);
+
+  Wire2.begin();
+  Wire2.setClock(400000);
+  pinPeripheral(W2_SDA, PIO_SERCOM);
+  pinPeripheral(W2_SCL, PIO_SERCOM);
+
+  dlc.setPressureUnit(AllSensors_DLC::PASCAL);
+  if (!dlc.startMeasurement()) {
+    Serial.println("DLC not found");
+  }
+  if (!sdp.checkForSensor() || !sdp.startContinuous(SDP8xx::DIFF_PRESSURE, true)) {
+    Serial.println("SDP8xx not found");
+  }
+
+  flow.setOrifice(8.0, 15.0);
+  detector.setEventHandler(onBreath);
+
+  Serial.println("breath, Vt in, Vt out, peak, plateau, PEEP, compliance");
+  nextSample = micros();
+}
+
+void loop() {
+  if ((long)(micros() - nextSample) < 0) return;
+  nextSample += SAMPLE_PERIOD_US;
+
+  // On a failed read the drivers keep the last value. The DLC converts on
+  // command: read the conversion started last tick, then start the next one
+  dlc.readData();
+  dlc.startMeasurement();
+  sdp.readData();
+
+  int32_t pressure = (int32_t)(dlc.pressure * 1000);
+  integrator.sample(flow.compute((int32_t)(sdp.pressure * 1000)), pressure);
+  detector.update(pressure, sampleCount++);
+}
+
+void printBreath(const TidalIntegrator::Breath &breath) {
+  Serial.print(breath.number);
+  Serial.print(", ");
+  Serial.print(breath.inspiredVolume / 1000.0, 1);
+  Serial.print(", ");
+  Serial.print(breath.expiredVolume / 1000.0, 1);
+  Serial.print(", ");
+  Serial.print(breath.peakPressure / CMH2O, 1);
+  Serial.print(", ");
+  Serial.print(breath.plateauPressure / CMH2O, 1);
+  Serial.print(", ");
+  Serial.print(breath.peep / CMH2O, 1);
+  Serial.print(", ");
+  Serial.println(breath.compliance / 1000.0, 1);
+}
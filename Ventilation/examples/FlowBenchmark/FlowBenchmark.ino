@@ -0,0 +1,84 @@
+/*
+
+    Benchmark for FlowEngine on the DevBoard.
+
+    Converts a synthetic breathing pressure trace (sine, +/- 300 Pa) with
+    both square roots and prints the cycles per sample for this core
+    (SAMD21, Cortex-M0+ at 48 MHz) and the largest difference against
+    the float computation. The host side, with a double reference, is
+    extras/flow_bench.
+
+*/
+
+#include <FlowEngine.h>
+
+#define NB_SAMPLES 256
+#define ROUNDS     16
+
+int32_t pressures[NB_SAMPLES];
+
+FlowEngine flow;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  for (int i = 0; i < NB_SAMPLES; i++) {
+    pressures[i] = (int32_t)(300000.0 * sin(i * 2.0 * PI / NB_SAMPLES));
+  }
+
+  flow.setOrifice(8.0, 15.0);
+
+  runBenchmark(FlowEngine::SQRT_EXACT, "Exact");
+  runBenchmark(FlowEngine::SQRT_LUT, "LUT");
+  runFloat();
+}
+
+void loop() {
+  // nothing to do
+}
+
+void runBenchmark(FlowEngine::SqrtMethod method, const char *name) {
+  flow.setSqrtMethod(method);
+
+  volatile int32_t sink = 0;
+  unsigned long start = micros();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (int i = 0; i < NB_SAMPLES; i++) {
+      sink += flow.compute(pressures[i]);
+    }
+  }
+  unsigned long elapsed = micros() - start;
+
+  float maxError = 0;
+  for (int i = 0; i < NB_SAMPLES; i++) {
+    float expected = flow.getCoefficient() * sqrt(fabs((float)pressures[i]));
+    if (pressures[i] < 0) expected = -expected;
+    float error = fabs(flow.compute(pressures[i]) - expected);
+    if (error > maxError) maxError = error;
+  }
+
+  Serial.print(name);
+  Serial.print(" cycles/sample: ");
+  Serial.print(elapsed * (F_CPU / 1000000.0) / ((float)NB_SAMPLES * ROUNDS));
+  Serial.print(", max error (uL/s): ");
+  Serial.println(maxError);
+}
+
+// The same computation in software float, for comparison
+void runFloat() {
+  float k = flow.getCoefficient();
+
+  volatile float sink = 0;
+  unsigned long start = micros();
+  for (int r = 0; r < ROUNDS; r++) {
+    for (int i = 0; i < NB_SAMPLES; i++) {
+      float q = k * sqrt(fabs((float)pressures[i]));
+      sink += (pressures[i] < 0) ? -q : q;
+    }
+  }
+  unsigned long elapsed = micros() - start;
+
+  Serial.print("Float cycles/sample: ");
+  Serial.println(elapsed * (F_CPU / 1000000.0) / ((float)NB_SAMPLES * ROUNDS));
+}
@@ -0,0 +1,87 @@
+/*
+
+    Waveform tables: a recorded breath (here a synthetic trace, in mPa)
+    is resampled into a 48-entry table, kept in FRAM (Wire2) with a CRC,
+    read back into RAM and played with WaveformGenerator, alternating at
+    every breath boundary with the compile-time sine table.
+
+*/
+
+#include <Wire.h>
+#include "wiring_private.h" // pinPeripheral() function
+#include <FRAM_MB85RC_I2C.h>
+#include <FRAM_CRC32.h>
+#include <WaveformGenerator.h>
+
+#define W2_SCL 13 // PA17 D13   SERCOM1.1 SERCOM3.1
+#define W2_SDA 11 // PA16 D11   SERCOM1.0 SERCOM3.0
+
+#define TABLE_LENGTH 48     // 96 bytes + CRC fit in one FRAM_BURST_SIZE block
+#define FRAM_TABLE   0x0100 // table, then base and amplitude
+#define SAMPLE_US    10000
+#define CMH2O        98067  // mPa
+
+TwoWire Wire2(&sercom1, W2_SDA, W2_SCL);
+FRAM_MB85RC_I2C fram(&Wire2, MB85RC_DEFAULT_ADDRESS, false, FRAM_NO_WP_PIN); // pin 13 is W2_SCL
+
+int32_t recording[150];        // one breath of 1.5 s at 10 ms
+int16_t recordedTable[TABLE_LENGTH];
+
+WaveformProfile recorded;
+const WaveformProfile sine = { WaveformTable<SineShape, 128>::values, 128, 3000000, 5 * CMH2O, 10 * CMH2O };
+
+WaveformGenerator waveform(SAMPLE_US);
+unsigned long nextSample;
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial);
+
+  Wire2.begin();
+  pinPeripheral(W2_SDA, PIO_SERCOM);
+  pinPeripheral(W2_SCL, PIO_SERCOM);
+  fram.begin();
+
+  makeRecording();
+
+  int32_t scale[2];
+  WaveformGenerator::resample(recording, 150, recordedTable, TABLE_LENGTH, &scale[0], &scale[1]);
+  fram.writeArrayCRC(FRAM_TABLE, sizeof(recordedTable), (uint8_t *) recordedTable);
+  fram.writeArray(FRAM_TABLE + sizeof(recordedTable) + FRAM_CRC32_SIZE, sizeof(scale), (uint8_t *) scale);
+
+  // as after a restart: from FRAM into RAM
+  if (fram.readArrayCRC(FRAM_TABLE, sizeof(recordedTable), (uint8_t *) recordedTable) != 0) {
+    Serial.println("table CRC error");
+  }
+  fram.readArray(FRAM_TABLE + sizeof(recordedTable) + FRAM_CRC32_SIZE, sizeof(scale), (uint8_t *) scale);
+
+  recorded.table = recordedTable;
+  recorded.length = TABLE_LENGTH;
+  recorded.breathUs = 2000000;
+  recorded.base = scale[0];
+  recorded.amplitude = scale[1];
+
+  waveform.start(recorded);
+  nextSample = micros();
+}
+
+void loop() {
+  if ((long)(micros() - nextSample) < 0) return;
+  nextSample += SAMPLE_US;
+
+  int32_t setpoint = waveform.next();
+  if (waveform.atBreathStart()) {
+    // the other profile from the next boundary on
+    waveform.queue((waveform.getProfile().table == recordedTable) ? sine : recorded);
+  }
+  Serial.println(setpoint / (float)CMH2O, 2);
+}
+
+// Fast rise, slowly decaying plateau, passive expiration
+void makeRecording() {
+  for (int i = 0; i < 150; i++) {
+    float t = i * 0.01;
+    float p = (t < 0.6) ? 20.0 * (1.0 - exp(-t / 0.08)) - 2.0 * t : 5.0 + 13.8 * exp(-(t - 0.6) / 0.15);
+    recording[i] = (int32_t)((p < 5.0 ? 5.0 : p) * CMH2O);
+  }
+}
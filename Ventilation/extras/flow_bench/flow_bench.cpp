@@ -0,0 +1,100 @@
+/*
+    flow_bench - host benchmark of FlowEngine against a double-precision reference.
+
+    Build:
+        g++ -O2 -std=c++11 -o flow_bench flow_bench.cpp ../../FlowEngine.cpp
+
+    Usage:
+        flow_bench [orifice_mm pipe_mm]
+
+    Sweeps dp over +/- the maximum pressure (every mPa up to 10 Pa, then
+    logarithmic steps), and for both square roots prints the maximum
+    absolute error (uL/s), the maximum relative error above 1 % of full
+    scale flow, and the time per sample on this host (ns and, on x86,
+    TSC cycles). Cycles on the DevBoard come from examples/FlowBenchmark.
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#include "../../FlowEngine.h"
+
+#define ROUNDS 64
+
+static double reference(double k, int32_t dp) {
+  return (dp < 0) ? -k * sqrt((double) -dp) : k * sqrt((double) dp);
+}
+
+static std::vector<int32_t> makeInputs(int32_t maxPressure) {
+  std::vector<int32_t> inputs;
+  for (int32_t dp = 0; dp <= 10000; dp++) inputs.push_back(dp);
+  for (double dp = 10000; dp <= maxPressure; dp *= 1.001) inputs.push_back((int32_t) dp);
+  inputs.push_back(maxPressure);
+
+  size_t n = inputs.size();
+  for (size_t i = 1; i < n; i++) inputs.push_back(-inputs[i]);
+  return inputs;
+}
+
+static void run(FlowEngine &flow, FlowEngine::SqrtMethod method, const char *name,
+                const std::vector<int32_t> &inputs, double fullScale) {
+  flow.setSqrtMethod(method);
+  double k = flow.getCoefficient();
+
+  double maxAbs = 0;
+  double maxRel = 0;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    double expected = reference(k, inputs[i]);
+    double error = fabs(flow.compute(inputs[i]) - expected);
+    if (error > maxAbs) maxAbs = error;
+    if ((fabs(expected) > fullScale / 100) && (error / fabs(expected) > maxRel)) maxRel = error / fabs(expected);
+  }
+
+  volatile int32_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+#ifdef HAVE_TSC
+  uint64_t tsc = __rdtsc();
+#endif
+  for (int r = 0; r < ROUNDS; r++) {
+    for (size_t i = 0; i < inputs.size(); i++) sink += flow.compute(inputs[i]);
+  }
+#ifdef HAVE_TSC
+  tsc = __rdtsc() - tsc;
+#endif
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  double samples = (double) inputs.size() * ROUNDS;
+
+  printf("%-6s  max abs error %8.2f uL/s  max rel error %.2e  %6.2f ns/sample", name, maxAbs, maxRel, ns / samples);
+#ifdef HAVE_TSC
+  printf("  %6.1f TSC cycles/sample", tsc / samples);
+#endif
+  printf("\n");
+  (void) sink;
+}
+
+int main(int argc, char **argv) {
+  float orifice = (argc > 2) ? atof(argv[1]) : 8.0;
+  float pipe = (argc > 2) ? atof(argv[2]) : 15.0;
+
+  FlowEngine flow;
+  flow.setOrifice(orifice, pipe);
+
+  std::vector<int32_t> inputs = makeInputs(FlowEngine::DEFAULT_MAX_PRESSURE);
+  double fullScale = reference(flow.getCoefficient(), FlowEngine::DEFAULT_MAX_PRESSURE);
+
+  printf("orifice %.1f mm in %.1f mm, K = %.3f uL/s per sqrt(mPa), full scale %.1f L/min, %u inputs\n",
+         orifice, pipe, flow.getCoefficient(), fullScale * 60e-6, (unsigned) inputs.size());
+
+  run(flow, FlowEngine::SQRT_EXACT, "exact", inputs, fullScale);
+  run(flow, FlowEngine::SQRT_LUT, "lut", inputs, fullScale);
+  return 0;
+}
@@ -25,6 +25,7 @@
 
 #include <Wire.h> // SERCOM3?
 #include "wiring_private.h" // pinPeripheral() function
+#include <I2CScanner.h>
 
 // i2c system bus
 #define W0_SCL 21 // PA22 D20 / SDA SERCOM3.0 SERCOM5.0
@@ -53,6 +54,14 @@ TwoWire Wire1(&sercom2, W1_SDA, W1_SCL); // Left sensor, diff sensor
 TwoWire Wire2(&sercom1, W2_SDA, W2_SCL); // EEPROM / SRAM
 // And of course standard Wire
 
+const char *busLabels[] = {
+  "0: on SERCOM3 (D20d/D21c)",
+  "1: on SERCOM2 (D4_SDA_PA08 / ﻿D3_SCL_PA09)",
+  "2: on SERCOM1 (D11_PA16_SDA1 /﻿D13_PA17_SCL1)"
+};
+
+I2CScanner scanner;
+
 void setup()
 {
   Serial.begin(115200);
@@ -71,6 +80,12 @@ void setup()
   pinPeripheral(W2_SCL, PIO_SERCOM);
   delay(1500);
 
+  // all three buses are probed at the same time
+  scanner.addBus(&Wire0, SERCOM3);
+  scanner.addBus(&Wire1, SERCOM2);
+  scanner.addBus(&Wire2, SERCOM1);
+  scanner.setChangeHandler(reportChange);
+
   Serial.println("Ready...");
   delay(1500);
 }
@@ -78,53 +93,38 @@ void setup()
 
 void loop()
 {
-  //exit;
+  digitalWrite(12, LOW);
+  uint16_t changes = scanner.scan(); // first scan reports every device, later scans only (un)plugged ones
   digitalWrite(12, HIGH);
-  reportDevicesOn(&Wire0, "0: on SERCOM3 (D20d/D21c)");
-  reportDevicesOn(&Wire1, "1: on SERCOM2 (D4_SDA_PA08 / ﻿D3_SCL_PA09)");
-  reportDevicesOn(&Wire2, "2: on SERCOM1 (D11_PA16_SDA1 /﻿D13_PA17_SCL1)");
 
-  delay(2500);           // wait 5 seconds for next scan
+  for (uint8_t bus = 0; bus < scanner.getBusCount(); bus++) {
+    if (scanner.hadTimeout(bus)) {
+      Serial.print("Bus ");
+      Serial.print(busLabels[bus]);
+      Serial.println(" timed out, check for a stuck SDA/SCL line");
+    }
+  }
+  if (changes > 0) {
+    Serial.print("Scan took ");
+    Serial.print(scanner.getLastScanMicros());
+    Serial.print(" us (max ");
+    Serial.print(scanner.getMaxScanMicros());
+    Serial.println(" us)\n");
+  }
+
+  delay(2500);           // wait 2.5 seconds for next scan
 }
 
-void reportDevicesOn(TwoWire *wire, String label) {
-  byte error, address;
-  int nDevices;
-  Serial.print("Scanning bus 1: ");
-  Serial.println(label);
-  for (address = 1; address < 127; address++ )
-  {
-    digitalWrite(12, LOW);
-    // The i2c_scanner uses the return value of
-    // the Write.endTransmisstion to see if
-    // a device did acknowledge to the address.
-    wire->beginTransmission(address);
-    error = wire->endTransmission();
-
-    if (error == 0)
-    {
-      digitalWrite(12, HIGH);
-      Serial.print("I2C device found at address 0x");
-      if (address < 16)
-        Serial.print("0");
-      Serial.print(address, HEX);
-      Serial.println("  !");
-      printDeviceName(address);
-
-      nDevices++;
-    }
-    else if (error == 4)
-    {
-      Serial.print("Unknow error at address 0x");
-      if (address < 16)
-        Serial.print("0");
-      Serial.println(address, HEX);
-    }
+void reportChange(uint8_t bus, uint8_t address, bool present) {
+  Serial.print(present ? "I2C device found at address 0x" : "I2C device removed from address 0x");
+  if (address < 16)
+    Serial.print("0");
+  Serial.print(address, HEX);
+  Serial.print(" on bus ");
+  Serial.println(busLabels[bus]);
+  if (present) {
+    printDeviceName(address);
   }
-  if (nDevices == 0)
-    Serial.println("No I2C devices found on bus 1\n");
-  else
-    Serial.println("done\n");
 }
 
 void printDeviceName(int address) {